@@ -0,0 +1,70 @@
+#include <benchmark/benchmark.h>
+
+#include <string>
+
+#include "lox/allocation.hpp"
+#include "lox/ast/interpreter.hpp"
+#include "workload.hpp"
+
+// Allocations are counted by the operator new lox replaces, on the benchmark's own thread
+auto bench::allocation_count() -> std::size_t { return lox::allocations().m_count; }
+
+namespace
+{
+// Counted for the whole run, as several benchmarks report or check their allocations
+auto const counting = [] {
+  lox::set_counting_allocations(true);
+  return true;
+}();
+
+// Concatenates three strings too long to be copied, which test/allocations.cpp checks allocates
+// only the two joins
+void BM_string_chain(benchmark::State& state)
+{
+  std::string const text(100, 'x');
+  std::string const source = "var a = \"" + text + "\"; var b = a; var c = a; a + b + c;";
+  auto const parsed = bench::parse(&state, source);
+  if (!parsed) return;
+  lox::Interpreter interpreter;
+  auto const& roots = parsed->m_program->m_expressions;
+  for (std::size_t i = 0; i + 1 < roots.size(); ++i) roots[i]->accept(interpreter);
+  auto const& chain = *dynamic_cast<lox::Statement const&>(*roots.back()).m_expression;
+
+  lox::AllocationScope const scope;
+  for (auto _ : state) benchmark::DoNotOptimize(interpreter.evaluate(chain));
+  state.counters["allocations"] =
+    benchmark::Counter(static_cast<double>(scope.stats().m_count), benchmark::Counter::kAvgIterations);
+}
+
+// Enters and leaves nested blocks declaring variables, which test/allocations.cpp checks allocates
+// nothing once the environment has grown to fit them
+void BM_nested_blocks(benchmark::State& state)
+{
+  std::string const source = "{ var a = 1; { var b = a; var c = b; { var d = c + a; } } { var e = a; } }";
+  auto const parsed = bench::parse(&state, source);
+  if (!parsed) return;
+  lox::Interpreter interpreter;
+  auto const& block = *parsed->m_program->m_expressions.front();
+  for (auto _ : state) benchmark::DoNotOptimize(interpreter.evaluate(block));
+}
+
+// Arithmetic and comparison over numbers, which must never allocate
+void BM_numeric_binary(benchmark::State& state)
+{
+  std::string const source = "var a = 2; (a + 1.5) * a - a / 4 < a;";
+  auto const parsed = bench::parse(&state, source);
+  if (!parsed) return;
+  lox::Interpreter interpreter;
+  auto const& roots = parsed->m_program->m_expressions;
+  roots.front()->accept(interpreter);
+  auto const& binary = *dynamic_cast<lox::Statement const&>(*roots.back()).m_expression;
+
+  lox::AllocationScope const scope;
+  for (auto _ : state) benchmark::DoNotOptimize(interpreter.evaluate(binary));
+  if (scope.stats().m_count != 0) state.SkipWithError("Evaluating a numeric Binary allocated.");
+}
+}  // namespace
+
+BENCHMARK(BM_string_chain);
+BENCHMARK(BM_nested_blocks);
+BENCHMARK(BM_numeric_binary);
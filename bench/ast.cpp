@@ -0,0 +1,147 @@
+#include <benchmark/benchmark.h>
+
+#include <memory>
+#include <optional>
+#include <string>
+
+#include "lox/ast/flat.hpp"
+#include "lox/ast/flat_interpreter.hpp"
+#include "lox/ast/interpreter.hpp"
+#include "lox/ast/parse.hpp"
+#include "lox/closure/compiler.hpp"
+#include "lox/vm/compiler.hpp"
+#include "lox/vm/vm.hpp"
+#include "workload.hpp"
+
+namespace
+{
+// A program of roughly `statements` declarations which evaluates without errors or output
+auto arithmetic_source(std::size_t statements) -> std::string
+{
+  std::string source;
+  for (std::size_t i = 0; i < statements; i += 4)
+  {
+    auto const n = std::to_string(i);
+    source += "var v" + n + " = " + n + " * 2 + 1;\n";
+    source += "{ var t = v" + n + " - 3 / 4; v" + n + " = t > 0 ? t : -t; }\n";
+    source += "var s" + n + " = \"value \" + v" + n + ";\n";
+    source += "v" + n + " = (v" + n + " + 1) * (v" + n + " - 1) == 0, !(s" + n + " == nil);\n";
+  }
+  return source;
+}
+
+// The workload, compiled for each engine
+struct Compiled
+{
+  std::unique_ptr<bench::Parsed> m_parsed;
+  lox::FlatAst m_flat;
+  lox::Chunk m_chunk;
+  lox::ClosureProgram m_closures;
+};
+
+// Whether every engine succeeds or fails alike on each declaration, leaving the same result
+auto engines_agree(Compiled const& compiled) -> bool
+{
+  auto const& roots = compiled.m_parsed->m_program->m_expressions;
+  lox::Interpreter tree;
+  lox::FlatInterpreter flat;
+  lox::VM vm;
+  lox::ClosureInterpreter closures;
+  for (std::size_t i = 0; i < roots.size(); ++i)
+  {
+    auto const ran = roots[i]->accept(tree).has_value();
+    if (flat.evaluate(compiled.m_flat, compiled.m_flat.m_roots[i]).has_value() != ran) return false;
+    if (vm.run(compiled.m_chunk, i).has_value() != ran) return false;
+    if (closures.run(compiled.m_closures, i).has_value() != ran) return false;
+    if (ran && (flat.result != tree.result || vm.result != tree.result || closures.result != tree.result))
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+// The engines are only worth comparing if they agree, so the workload is skipped if they don't
+auto compile_workload(benchmark::State* state) -> std::optional<Compiled>
+{
+  auto parsed = bench::parse(state, arithmetic_source(state->range(0)));
+  if (!parsed) return std::nullopt;
+  auto const& program = *parsed->m_program;
+  auto flat = lox::flatten(program, &parsed->m_pool);
+  auto chunk = lox::compile(program);
+  Compiled compiled{std::move(parsed), std::move(flat), std::move(chunk), lox::compile_closures(program)};
+  if (!engines_agree(compiled))
+  {
+    state->SkipWithError("Engines disagree on the workload.");
+    return std::nullopt;
+  }
+  return compiled;
+}
+
+void BM_execute_tree(benchmark::State& state)
+{
+  auto const compiled = compile_workload(&state);
+  if (!compiled) return;
+  auto const& roots = compiled->m_parsed->m_program->m_expressions;
+  bench::TreeSize size;
+  for (auto const& expr : roots) expr->accept(size);
+  for (auto _ : state)
+  {
+    lox::Interpreter interpreter;
+    for (auto const& expr : roots) expr->accept(interpreter);
+    benchmark::DoNotOptimize(interpreter.result);
+  }
+  state.SetItemsProcessed(state.iterations() * compiled->m_flat.size());
+  state.counters["ast_bytes"] = size.m_bytes;
+}
+
+void BM_execute_flat(benchmark::State& state)
+{
+  auto const compiled = compile_workload(&state);
+  if (!compiled) return;
+  auto const& ast = compiled->m_flat;
+  for (auto _ : state)
+  {
+    lox::FlatInterpreter interpreter;
+    for (auto root : ast.m_roots) interpreter.evaluate(ast, root);
+    benchmark::DoNotOptimize(interpreter.result);
+  }
+  state.SetItemsProcessed(state.iterations() * ast.size());
+  state.counters["ast_bytes"] = ast.size_bytes();
+}
+
+void BM_execute_vm(benchmark::State& state)
+{
+  auto const compiled = compile_workload(&state);
+  if (!compiled) return;
+  auto const& chunk = compiled->m_chunk;
+  for (auto _ : state)
+  {
+    lox::VM vm;
+    for (std::size_t i = 0; i < chunk.m_roots.size(); ++i) vm.run(chunk, i);
+    benchmark::DoNotOptimize(vm.result);
+  }
+  state.SetItemsProcessed(state.iterations() * compiled->m_flat.size());
+  state.counters["code_bytes"] = chunk.m_code.size();
+}
+
+void BM_execute_closure(benchmark::State& state)
+{
+  auto const compiled = compile_workload(&state);
+  if (!compiled) return;
+  auto const& closures = compiled->m_closures;
+  for (auto _ : state)
+  {
+    lox::ClosureInterpreter interpreter;
+    for (std::size_t i = 0; i < closures.m_roots.size(); ++i) interpreter.run(closures, i);
+    benchmark::DoNotOptimize(interpreter.result);
+  }
+  state.SetItemsProcessed(state.iterations() * compiled->m_flat.size());
+}
+}  // namespace
+
+// Items processed are nodes executed
+BENCHMARK(BM_execute_tree)->Range(1 << 6, 1 << 14);
+BENCHMARK(BM_execute_flat)->Range(1 << 6, 1 << 14);
+BENCHMARK(BM_execute_vm)->Range(1 << 6, 1 << 14);
+BENCHMARK(BM_execute_closure)->Range(1 << 6, 1 << 14);
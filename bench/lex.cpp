@@ -0,0 +1,85 @@
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <iterator>
+#include <string>
+#include <thread>
+
+#include "lox/lex.hpp"
+
+namespace
+{
+// Deterministically build roughly `size` bytes of source which exercises every kind of token
+auto synthetic_source(std::size_t size) -> std::string
+{
+  static constexpr std::string_view lines[] = {
+    "var identifier_{} = {} * (4 + -3.25 / 2) >= 7 ? \"yes\" : \"no\";\n",
+    "// A line comment describing variable number {} and {}\n",
+    "{{ var shadow_{} = identifier_{} + \"string literal\"; print shadow_{} != nil; }}\n",
+    "/* A block comment\n   spanning {} lines */ print !true == false and {} <= 10;\n",
+  };
+  std::string source;
+  source.reserve(size);
+  for (std::size_t i = 0; source.size() < size; ++i)
+  {
+    auto const line = lines[i % std::size(lines)];
+    auto const n = std::to_string(i);
+    // Substitute every placeholder with the line number
+    for (std::size_t pos = 0, next; pos < line.size(); pos = next + 2)
+    {
+      next = line.find("{}", pos);
+      if (next == std::string_view::npos)
+      {
+        source.append(line.substr(pos));
+        break;
+      }
+      source.append(line.substr(pos, next - pos)).append(n);
+    }
+  }
+  return source;
+}
+
+template <lox::LEX_BACKEND Backend>
+void BM_lex(benchmark::State& state)
+{
+  auto const source = synthetic_source(state.range(0));
+  // test/lex.cpp checks that both backends produce the same tokens
+  std::size_t tokens = 0;
+  for (auto _ : state)
+  {
+    lox::StringPool pool;
+    auto lexed = lox::lex(source, &pool, Backend);
+    tokens = lexed ? lexed->size() : 0;
+    benchmark::DoNotOptimize(lexed);
+  }
+  state.SetBytesProcessed(state.iterations() * source.size());
+  state.counters["tokens"] = tokens;
+}
+
+void BM_lex_parallel(benchmark::State& state)
+{
+  auto const source = synthetic_source(1 << 25);
+  auto const threads = static_cast<std::size_t>(state.range(0));
+  // test/lex.cpp checks that the parallel lexer reproduces the sequential one exactly
+  for (auto _ : state)
+  {
+    lox::StringPool pool;
+    auto tokens = lox::lex_parallel(source, &pool, threads);
+    benchmark::DoNotOptimize(tokens);
+  }
+  state.SetBytesProcessed(state.iterations() * source.size());
+  state.counters["threads"] = threads;
+}
+
+// Scale from a single thread up to every core
+void thread_args(benchmark::internal::Benchmark* bench)
+{
+  auto const cores = std::max(1u, std::thread::hardware_concurrency());
+  for (unsigned threads = 1; threads < cores; threads *= 2) bench->Arg(threads);
+  bench->Arg(cores);
+}
+}  // namespace
+
+BENCHMARK_TEMPLATE(BM_lex, lox::LEX_BACKEND::REGEX)->Range(1 << 10, 1 << 22);
+BENCHMARK_TEMPLATE(BM_lex, lox::LEX_BACKEND::SCANNER)->Range(1 << 10, 1 << 22);
+BENCHMARK(BM_lex_parallel)->Apply(thread_args)->UseRealTime()->Unit(benchmark::kMillisecond);
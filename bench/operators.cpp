@@ -0,0 +1,29 @@
+#include <benchmark/benchmark.h>
+
+#include "lox/allocation.hpp"
+#include "lox/operators.hpp"
+
+namespace
+{
+// Adding two numbers, which succeeds
+void BM_binary_success(benchmark::State& state)
+{
+  lox::Value const lhs{1.5f};
+  lox::Value const rhs{2.f};
+  for (auto _ : state) benchmark::DoNotOptimize(lox::binary(lox::TOKEN_TYPE::PLUS, lhs, rhs));
+}
+
+// Adding nil to a number, which is a type error that must be raised without allocating
+void BM_binary_error(benchmark::State& state)
+{
+  lox::Value const lhs{};
+  lox::Value const rhs{2.f};
+  lox::AllocationScope const scope;
+  for (auto _ : state) benchmark::DoNotOptimize(lox::binary(lox::TOKEN_TYPE::PLUS, lhs, rhs));
+  if (scope.stats().m_count != 0) state.SkipWithError("Raising a type error allocated.");
+}
+}  // namespace
+
+BENCHMARK(BM_binary_success);
+BENCHMARK(BM_binary_error);
+BENCHMARK(BM_binary_error)->Threads(4);
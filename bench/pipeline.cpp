@@ -0,0 +1,147 @@
+#include <benchmark/benchmark.h>
+
+#include <string>
+
+#include "lox/ast/interpreter.hpp"
+#include "lox/ast/parse.hpp"
+#include "lox/ast/printer.hpp"
+#include "lox/lex.hpp"
+#include "workload.hpp"
+
+// Each stage of the pipeline measured in isolation over every synthetic workload. Throughput is
+// reported in source bytes, along with the tokens or nodes handled per second and the allocations
+// made by each iteration.
+namespace
+{
+using bench::WORKLOAD;
+
+// Nodes in a parsed workload
+auto node_count(bench::Parsed const& parsed) -> std::size_t
+{
+  bench::TreeSize size;
+  for (auto const& expr : parsed.m_program->m_expressions) expr->accept(size);
+  return size.m_nodes;
+}
+
+auto per_second(benchmark::State const& state, std::size_t count) -> benchmark::Counter
+{
+  return benchmark::Counter(static_cast<double>(count) * state.iterations(), benchmark::Counter::kIsRate);
+}
+
+// Source throughput, and the allocations made per iteration since the count was before
+auto report(benchmark::State& state, std::string const& source, std::size_t before) -> void
+{
+  state.SetBytesProcessed(state.iterations() * source.size());
+  state.counters["allocations"] = benchmark::Counter(
+    static_cast<double>(bench::allocation_count() - before), benchmark::Counter::kAvgIterations);
+}
+
+template <WORKLOAD Workload>
+void BM_lex_workload(benchmark::State& state)
+{
+  auto const source = bench::generate(Workload, state.range(0));
+  std::size_t tokens = 0;
+  auto const before = bench::allocation_count();
+  for (auto _ : state)
+  {
+    lox::StringPool pool;
+    auto lexed = lox::lex(source, &pool);
+    if (!lexed)
+    {
+      state.SkipWithError("Failed to lex workload.");
+      return;
+    }
+    tokens = lexed->size();
+    benchmark::DoNotOptimize(lexed);
+  }
+  report(state, source, before);
+  state.counters["tokens"] = per_second(state, tokens);
+}
+
+// Parsing pulls tokens from the lexer as it goes, so this includes lexing
+template <WORKLOAD Workload>
+void BM_parse(benchmark::State& state)
+{
+  auto const parsed = bench::parse(&state, bench::generate(Workload, state.range(0)));
+  if (!parsed) return;
+  auto const& source = parsed->m_source;
+  auto const before = bench::allocation_count();
+  for (auto _ : state)
+  {
+    lox::StringPool pool;
+    lox::TokenStream tokens{source, &pool};
+    auto program = lox::parse(tokens);
+    benchmark::DoNotOptimize(program);
+  }
+  report(state, source, before);
+  state.counters["nodes"] = per_second(state, node_count(*parsed));
+}
+
+template <WORKLOAD Workload>
+void BM_interpret(benchmark::State& state)
+{
+  auto const parsed = bench::parse(&state, bench::generate(Workload, state.range(0)));
+  if (!parsed) return;
+  auto const& roots = parsed->m_program->m_expressions;
+  auto const before = bench::allocation_count();
+  for (auto _ : state)
+  {
+    lox::Interpreter interpreter;
+    for (auto const& expr : roots) expr->accept(interpreter);
+    benchmark::DoNotOptimize(interpreter.result);
+  }
+  report(state, parsed->m_source, before);
+  state.counters["nodes"] = per_second(state, node_count(*parsed));
+}
+
+template <WORKLOAD Workload>
+void BM_print(benchmark::State& state)
+{
+  auto const parsed = bench::parse(&state, bench::generate(Workload, state.range(0)));
+  if (!parsed) return;
+  auto const& roots = parsed->m_program->m_expressions;
+  auto const before = bench::allocation_count();
+  for (auto _ : state)
+  {
+    // One printer per declaration, as the lox binary does
+    for (auto const& expr : roots)
+    {
+      lox::AstPrinter printer;
+      expr->accept(printer);
+      benchmark::DoNotOptimize(printer.m_ast);
+    }
+  }
+  report(state, parsed->m_source, before);
+  state.counters["nodes"] = per_second(state, node_count(*parsed));
+}
+
+// Sources from a kilobyte up to multiple megabytes
+void source_sizes(benchmark::internal::Benchmark* bench)
+{
+  bench->RangeMultiplier(16)->Range(1 << 10, 1 << 22)->Unit(benchmark::kMicrosecond);
+}
+}  // namespace
+
+BENCHMARK_TEMPLATE(BM_lex_workload, WORKLOAD::NESTED)->Apply(source_sizes);
+BENCHMARK_TEMPLATE(BM_lex_workload, WORKLOAD::VARIABLES)->Apply(source_sizes);
+BENCHMARK_TEMPLATE(BM_lex_workload, WORKLOAD::STRINGS)->Apply(source_sizes);
+BENCHMARK_TEMPLATE(BM_lex_workload, WORKLOAD::BLOCKS)->Apply(source_sizes);
+BENCHMARK_TEMPLATE(BM_lex_workload, WORKLOAD::MIXED)->Apply(source_sizes);
+
+BENCHMARK_TEMPLATE(BM_parse, WORKLOAD::NESTED)->Apply(source_sizes);
+BENCHMARK_TEMPLATE(BM_parse, WORKLOAD::VARIABLES)->Apply(source_sizes);
+BENCHMARK_TEMPLATE(BM_parse, WORKLOAD::STRINGS)->Apply(source_sizes);
+BENCHMARK_TEMPLATE(BM_parse, WORKLOAD::BLOCKS)->Apply(source_sizes);
+BENCHMARK_TEMPLATE(BM_parse, WORKLOAD::MIXED)->Apply(source_sizes);
+
+BENCHMARK_TEMPLATE(BM_interpret, WORKLOAD::NESTED)->Apply(source_sizes);
+BENCHMARK_TEMPLATE(BM_interpret, WORKLOAD::VARIABLES)->Apply(source_sizes);
+BENCHMARK_TEMPLATE(BM_interpret, WORKLOAD::STRINGS)->Apply(source_sizes);
+BENCHMARK_TEMPLATE(BM_interpret, WORKLOAD::BLOCKS)->Apply(source_sizes);
+BENCHMARK_TEMPLATE(BM_interpret, WORKLOAD::MIXED)->Apply(source_sizes);
+
+BENCHMARK_TEMPLATE(BM_print, WORKLOAD::NESTED)->Apply(source_sizes);
+BENCHMARK_TEMPLATE(BM_print, WORKLOAD::VARIABLES)->Apply(source_sizes);
+BENCHMARK_TEMPLATE(BM_print, WORKLOAD::STRINGS)->Apply(source_sizes);
+BENCHMARK_TEMPLATE(BM_print, WORKLOAD::BLOCKS)->Apply(source_sizes);
+BENCHMARK_TEMPLATE(BM_print, WORKLOAD::MIXED)->Apply(source_sizes);
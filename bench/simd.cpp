@@ -0,0 +1,115 @@
+#include <benchmark/benchmark.h>
+
+#include <magic_enum/magic_enum.hpp>
+#include <string>
+
+#include "lox/lex.hpp"
+#include "lox/simd.hpp"
+
+namespace
+{
+// Roughly `size` bytes of source dominated by block and line comments
+auto comment_heavy_source(std::size_t size) -> std::string
+{
+  std::string source;
+  source.reserve(size);
+  for (std::size_t i = 0; source.size() < size; ++i)
+  {
+    source += "/* A block comment which explains in some detail what the next\n"
+              "   statement does, and why it has to do it that way. */\n";
+    source += "var x" + std::to_string(i) + " = " + std::to_string(i) + "; // Trailing line comment\n";
+  }
+  return source;
+}
+
+// Roughly `size` bytes of source dominated by long string literals
+auto string_heavy_source(std::size_t size) -> std::string
+{
+  std::string source;
+  source.reserve(size);
+  for (std::size_t i = 0; source.size() < size; ++i)
+  {
+    source += "print \"A fairly long string literal, of the kind used for messages and templates,\n"
+              "which continues onto a second line before it is closed\" + \"" +
+              std::to_string(i) + "\";\n";
+  }
+  return source;
+}
+
+// Select the kernels under test, skipping if this machine can't run them
+auto select_isa(benchmark::State& state) -> bool
+{
+  auto const isa = static_cast<lox::simd::ISA>(state.range(0));
+  state.SetLabel(std::string{magic_enum::enum_name(isa)});
+  if (lox::simd::set_isa(isa) == isa) return true;
+  state.SkipWithError("Instruction set not supported on this machine.");
+  return false;
+}
+
+void BM_simd_skip_whitespace(benchmark::State& state)
+{
+  if (!select_isa(state)) return;
+  std::string const source = std::string(1 << 16, ' ') + std::string(1 << 8, '\n') + "x";
+  for (auto _ : state)
+  {
+    auto const skipped = lox::simd::skip_whitespace(source.data(), source.data() + source.size());
+    benchmark::DoNotOptimize(skipped);
+  }
+  state.SetBytesProcessed(state.iterations() * source.size());
+}
+
+void BM_simd_find_comment_end(benchmark::State& state)
+{
+  if (!select_isa(state)) return;
+  std::string source;
+  while (source.size() < (1 << 16)) source += " * Comment body, with stray * characters and\n";
+  source += "*/";
+  for (auto _ : state)
+  {
+    // Stray '*' characters are never followed by a '/', so the only close is the final one
+    auto const end = lox::simd::find_comment_end(source.data(), source.data() + source.size());
+    benchmark::DoNotOptimize(end);
+  }
+  state.SetBytesProcessed(state.iterations() * source.size());
+}
+
+void BM_simd_find_quote(benchmark::State& state)
+{
+  if (!select_isa(state)) return;
+  std::string source;
+  while (source.size() < (1 << 16)) source += "string body text spanning\nmultiple lines ";
+  source += '"';
+  for (auto _ : state)
+  {
+    auto const end = lox::simd::find(source.data(), source.data() + source.size(), '"');
+    benchmark::DoNotOptimize(end);
+  }
+  state.SetBytesProcessed(state.iterations() * source.size());
+}
+
+template <auto Generate>
+void BM_simd_lex(benchmark::State& state)
+{
+  if (!select_isa(state)) return;
+  auto const source = Generate(1 << 20);
+  for (auto _ : state)
+  {
+    lox::StringPool pool;
+    auto tokens = lox::lex(source, &pool, lox::LEX_BACKEND::SCANNER);
+    benchmark::DoNotOptimize(tokens);
+  }
+  state.SetBytesProcessed(state.iterations() * source.size());
+}
+
+// Run every benchmark once per instruction set
+void isa_args(benchmark::internal::Benchmark* bench)
+{
+  for (auto isa : magic_enum::enum_values<lox::simd::ISA>()) bench->Arg(magic_enum::enum_integer(isa));
+}
+}  // namespace
+
+BENCHMARK(BM_simd_skip_whitespace)->Apply(isa_args);
+BENCHMARK(BM_simd_find_comment_end)->Apply(isa_args);
+BENCHMARK(BM_simd_find_quote)->Apply(isa_args);
+BENCHMARK_TEMPLATE(BM_simd_lex, comment_heavy_source)->Apply(isa_args);
+BENCHMARK_TEMPLATE(BM_simd_lex, string_heavy_source)->Apply(isa_args);
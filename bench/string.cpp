@@ -0,0 +1,38 @@
+#include <benchmark/benchmark.h>
+
+#include <string>
+#include <string_view>
+
+#include "lox/ast/interpreter.hpp"
+#include "workload.hpp"
+
+namespace
+{
+constexpr std::string_view piece = "a piece of output, 32 bytes long";
+
+// A program which builds a string one piece at a time, then compares it so that it has to be
+// flattened
+auto concatenation_source(std::size_t pieces) -> std::string
+{
+  std::string source = "var s = \"\";\n";
+  for (std::size_t i = 0; i < pieces; ++i) source += "s = s + \"" + std::string{piece} + "\";\n";
+  source += "var done = s == \"\";\n";
+  return source;
+}
+
+void BM_concatenate(benchmark::State& state)
+{
+  auto const parsed = bench::parse(&state, concatenation_source(state.range(0)));
+  if (!parsed) return;
+  for (auto _ : state)
+  {
+    lox::Interpreter interpreter;
+    for (auto const& expr : parsed->m_program->m_expressions) expr->accept(interpreter);
+    benchmark::DoNotOptimize(interpreter.result);
+  }
+  // Bytes in the final string
+  state.SetBytesProcessed(state.iterations() * state.range(0) * piece.size());
+}
+}  // namespace
+
+BENCHMARK(BM_concatenate)->Range(1 << 8, 1 << 16);
@@ -0,0 +1,79 @@
+#include "workload.hpp"
+
+#include <fmt/format.h>
+
+#include <array>
+#include <string_view>
+#include <utility>
+
+#include "lox/ast/resolve.hpp"
+
+namespace bench
+{
+namespace
+{
+// The i'th statement of a workload, which may only refer to globals declared by earlier statements
+auto statement(WORKLOAD workload, std::size_t i) -> std::string
+{
+  switch (workload)
+  {
+  case WORKLOAD::NESTED:
+  {
+    static constexpr std::array<std::string_view, 4> ops = {"+", "*", "-", "/"};
+    auto const depth = 16 + i % 48;
+    std::string source = fmt::format("var n{} = -{}{}", i, std::string(depth, '('), i);
+    for (std::size_t k = 0; k < depth; ++k) source += fmt::format(" {} {})", ops[k % ops.size()], k + 1);
+    return source + fmt::format(" < {} ? !true : !!false;\n", i);
+  }
+  case WORKLOAD::VARIABLES:
+  {
+    if (i == 0) return "var v0 = 0;\n";
+    return fmt::format("var v{0} = v{1} + {0};\nv{2} = v{0} - v{2};\n", i, i - 1, i / 2);
+  }
+  case WORKLOAD::STRINGS:
+  {
+    return fmt::format("var s{0} = \"string {0} \" + \"joined to \" + \"a literal\" + {0};\n"
+                       "var c{0} = s{0} == \"string {0} joined to a literal\" ? \"same\" : \"different\";\n",
+                       i);
+  }
+  case WORKLOAD::BLOCKS:
+  {
+    return fmt::format("var b{0} = {{ var a = {0}; {{ var b = a + 1; {{ var a = b * 2; b = a; }} a = b; }} "
+                       "a }};\n{{ var x = b{0}; {{ var y = x; {{ x = y + 1; }} }} {{ var x = nil; }} }}\n",
+                       i);
+  }
+  case WORKLOAD::MIXED:
+  {
+    // Each shape numbers its own globals, so every reference still refers to an earlier statement
+    return statement(static_cast<WORKLOAD>(i % 4), i / 4);
+  }
+  }
+  return {};
+}
+}  // namespace
+
+auto generate(WORKLOAD workload, std::size_t size) -> std::string
+{
+  std::string source;
+  source.reserve(size + 512);
+  for (std::size_t i = 0; source.size() < size; ++i) source += statement(workload, i);
+  return source;
+}
+
+auto parse(benchmark::State* state, std::string source) -> std::unique_ptr<Parsed>
+{
+  // Tokens refer into the source and names into the pool, so neither may move once parsed
+  auto parsed = std::make_unique<Parsed>();
+  parsed->m_source = std::move(source);
+  lox::TokenStream tokens{parsed->m_source, &parsed->m_pool};
+  auto program = lox::parse(tokens);
+  if (!program)
+  {
+    state->SkipWithError("Failed to parse workload.");
+    return nullptr;
+  }
+  parsed->m_program.emplace(std::move(*program));
+  lox::Resolver{}.resolve(&*parsed->m_program);
+  return parsed;
+}
+}  // namespace bench
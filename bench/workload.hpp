@@ -0,0 +1,95 @@
+#pragma once
+#if !defined(LOX_BENCH_WORKLOAD_H)
+#define LOX_BENCH_WORKLOAD_H
+
+#include <benchmark/benchmark.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+
+#include "lox/ast/expression.hpp"
+#include "lox/ast/parse.hpp"
+#include "lox/string_pool.hpp"
+
+namespace bench
+{
+/// Shapes of synthetic program, each stressing a different part of the pipeline
+enum class WORKLOAD : uint8_t
+{
+  // Arithmetic parenthesised dozens of levels deep
+  NESTED,
+  // Thousands of globals, each read and assigned
+  VARIABLES,
+  // String literals, concatenation and comparison
+  STRINGS,
+  // Blocks nested inside one another, declaring and shadowing locals
+  BLOCKS,
+  // All of the above, interleaved
+  MIXED,
+};
+
+/// Deterministically generate roughly size bytes of source shaped like workload, which runs without
+/// errors or output
+auto generate(WORKLOAD workload, std::size_t size) -> std::string;
+
+/// A resolved program, with the source its tokens refer into and the pool its names are interned in
+struct Parsed
+{
+  std::string m_source;
+  lox::StringPool m_pool;
+  std::optional<lox::Program> m_program;
+};
+
+/// Parse and resolve source. If it doesn't parse, state is skipped with an error and null returned.
+auto parse(benchmark::State* state, std::string source) -> std::unique_ptr<Parsed>;
+
+/// Number of allocations made by the benchmark process so far
+auto allocation_count() -> std::size_t;
+
+/// Counts the nodes in a tree and sums their size, including the child lists of blocks
+struct TreeSize final : public lox::AstVisitor
+{
+  virtual auto visit(lox::Definition const& e) -> lox::result<void> override { return add(e, *e.m_value); }
+  virtual auto visit(lox::Read const& e) -> lox::result<void> override { return add(e); }
+  virtual auto visit(lox::Statement const& e) -> lox::result<void> override
+  {
+    return add(e, *e.m_expression);
+  }
+  virtual auto visit(lox::Block const& e) -> lox::result<void> override
+  {
+    ++m_nodes;
+    m_bytes += sizeof(e) + e.m_expressions.size_bytes();
+    for (auto const& child : e.m_expressions) child->accept(*this);
+    return lox::ok();
+  }
+  virtual auto visit(lox::Print const& e) -> lox::result<void> override { return add(e, *e.m_value); }
+  virtual auto visit(lox::Assign const& e) -> lox::result<void> override { return add(e, *e.m_value); }
+  virtual auto visit(lox::Ternary const& e) -> lox::result<void> override
+  {
+    return add(e, *e.m_cond, *e.m_left, *e.m_right);
+  }
+  virtual auto visit(lox::Binary const& e) -> lox::result<void> override
+  {
+    return add(e, *e.m_left, *e.m_right);
+  }
+  virtual auto visit(lox::Group const& e) -> lox::result<void> override { return add(e, *e.m_expression); }
+  virtual auto visit(lox::Literal const& e) -> lox::result<void> override { return add(e); }
+  virtual auto visit(lox::Unary const& e) -> lox::result<void> override { return add(e, *e.m_expression); }
+
+  template <typename T, typename... Children>
+  auto add(T const& node, Children const&... children) -> lox::result<void>
+  {
+    ++m_nodes;
+    m_bytes += sizeof(node);
+    (children.accept(*this), ...);
+    return lox::ok();
+  }
+  std::size_t m_nodes = 0;
+  std::size_t m_bytes = 0;
+};
+}  // namespace bench
+
+#endif  // LOX_BENCH_WORKLOAD_H
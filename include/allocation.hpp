@@ -0,0 +1,52 @@
+#pragma once
+#if !defined(LOX_ALLOCATION_H)
+#define LOX_ALLOCATION_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace lox
+{
+/// Allocations made through the global operator new. Only counted in programs which link
+/// lox-count-allocations, and only once set_counting_allocations() turns counting on, elsewhere they
+/// stay zero. Counts are kept per thread, so concurrent work doesn't disturb a measurement.
+struct AllocationStats
+{
+  std::uint64_t m_count = 0;
+  std::uint64_t m_bytes = 0;
+};
+
+inline auto operator+(AllocationStats lhs, AllocationStats rhs) -> AllocationStats
+{
+  return {lhs.m_count + rhs.m_count, lhs.m_bytes + rhs.m_bytes};
+}
+
+inline auto operator-(AllocationStats lhs, AllocationStats rhs) -> AllocationStats
+{
+  return {lhs.m_count - rhs.m_count, lhs.m_bytes - rhs.m_bytes};
+}
+
+/// Everything the calling thread has allocated since it started
+auto allocations() -> AllocationStats;
+
+/// Start or stop counting allocations on every thread, off by default
+auto set_counting_allocations(bool enabled) -> void;
+
+/// Add an allocation of size bytes to the calling thread's count while counting is on, made by the
+/// replacement operator new
+auto count_allocation(std::size_t size) noexcept -> void;
+
+/// Measures what the calling thread allocates from its construction onwards, for asserting budgets
+/// such as a numeric Binary evaluating without allocating
+struct AllocationScope
+{
+  auto stats() const -> AllocationStats { return allocations() - m_start; }
+
+  AllocationStats m_start = allocations();
+};
+
+/// Peak resident set size of the process so far, in bytes
+auto peak_resident_bytes() -> std::size_t;
+}  // namespace lox
+
+#endif  // LOX_ALLOCATION_H
@@ -0,0 +1,70 @@
+#pragma once
+#if !defined(LOX_ARENA_H)
+#define LOX_ARENA_H
+
+#include <gsl/span>
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace lox
+{
+/// Bump allocator for objects which all share a lifetime. Objects are placed in large blocks and
+/// destroyed together when the arena is, so allocating is a pointer increment and freeing is a
+/// handful of block deallocations. Only objects with non-trivial destructors are tracked.
+struct Arena
+{
+  Arena() = default;
+  Arena(Arena&&) = default;
+  auto operator=(Arena&&) -> Arena& = delete;
+  ~Arena();
+
+  /// Construct a T in the arena, it lives until the arena is destroyed
+  template <typename T, typename... Args>
+  auto make(Args&&... args) -> T*
+  {
+    auto const object = new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+    if constexpr (!std::is_trivially_destructible_v<T>)
+    {
+      m_destructors.push_back({[](void* p) { static_cast<T*>(p)->~T(); }, object});
+    }
+    return object;
+  }
+
+  /// Copy a range into contiguous storage in the arena
+  template <typename T>
+  auto copy(std::vector<T> const& values) -> gsl::span<T const>
+  {
+    static_assert(std::is_trivially_copyable_v<T>, "Arena arrays are never destroyed.");
+    auto const data = static_cast<T*>(allocate(sizeof(T) * values.size(), alignof(T)));
+    std::uninitialized_copy(values.begin(), values.end(), data);
+    return {data, static_cast<std::ptrdiff_t>(values.size())};
+  }
+
+  /// Reserve uninitialized, suitably aligned storage
+  auto allocate(std::size_t size, std::size_t align) -> void*;
+
+  static constexpr std::size_t block_size = 1 << 16;
+
+  struct Destructor
+  {
+    void (*m_destroy)(void*);
+    void* m_object;
+  };
+
+  std::vector<std::unique_ptr<std::byte[]>> m_blocks;
+  // Total size of the blocks
+  std::size_t m_reserved = 0;
+  // Unused space at the end of the newest block
+  std::byte* m_next = nullptr;
+  std::size_t m_remaining = 0;
+  // Destroyed in reverse order of construction
+  std::vector<Destructor> m_destructors;
+};
+}  // namespace lox
+
+#endif  // LOX_ARENA_H
@@ -0,0 +1,47 @@
+#pragma once
+#if !defined(LOX_AST_CACHE_H)
+#define LOX_AST_CACHE_H
+
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <string_view>
+
+#include "lox/ast/parse.hpp"
+#include "lox/error.hpp"
+#include "lox/string_pool.hpp"
+
+namespace lox
+{
+/// Version of the cache format. Node kinds and token types are stored by value, so this must be
+/// bumped whenever either enum or the layout of a serialized node changes.
+constexpr std::uint32_t cache_version = 1;
+
+/// Hash identifying the contents of a source
+auto content_hash(std::string_view source) -> std::uint64_t;
+
+/// Where the parse of a script is cached: in directory keyed by the hash of source when one is
+/// given, otherwise next to the script
+auto cache_path(std::filesystem::path const& script,
+                std::optional<std::filesystem::path> const& directory,
+                std::string_view source) -> std::filesystem::path;
+
+/// Serialize a freshly parsed program, before it is optimized or resolved, as parsed from source
+auto serialize(Program const& program, std::string_view source) -> std::string;
+
+/// Rebuild a program serialized from source by this version of lox. Returns nothing if bytes were
+/// written by another version, for other source or are damaged. Names are interned in pool.
+auto deserialize(std::string_view bytes, std::string_view source, StringPool* pool) -> std::optional<Program>;
+
+/// Map the cache at path and load it in place of lexing and parsing source, if it is still valid
+auto load_cached(std::filesystem::path const& path, std::string_view source, StringPool* pool)
+  -> std::optional<Program>;
+
+/// Write the cache for a freshly parsed program. The file is replaced atomically, so concurrent runs
+/// never see it half written.
+auto store_cached(std::filesystem::path const& path, Program const& program, std::string_view source)
+  -> result<void>;
+}  // namespace lox
+
+#endif  // LOX_AST_CACHE_H
@@ -0,0 +1,40 @@
+#pragma once
+#if !defined(LOX_AST_COUNT_H)
+#define LOX_AST_COUNT_H
+
+#include <array>
+#include <cstddef>
+#include <numeric>
+
+#include <magic_enum/magic_enum.hpp>
+
+#include "lox/ast/parse.hpp"
+
+namespace lox
+{
+/// Number of nodes of each kind, indexed by NODE_KIND
+using NodeCounts = std::array<std::size_t, magic_enum::enum_count<NODE_KIND>()>;
+
+/// Size of a node of each kind, indexed by NODE_KIND
+inline constexpr NodeCounts node_sizes = {sizeof(Definition),
+                                          sizeof(Read),
+                                          sizeof(Statement),
+                                          sizeof(Block),
+                                          sizeof(Print),
+                                          sizeof(Assign),
+                                          sizeof(Ternary),
+                                          sizeof(Binary),
+                                          sizeof(Group),
+                                          sizeof(Literal),
+                                          sizeof(Unary)};
+
+/// Count the nodes of each kind in a program
+auto count_nodes(Program const& program) -> NodeCounts;
+
+inline auto total(NodeCounts const& counts) -> std::size_t
+{
+  return std::accumulate(counts.begin(), counts.end(), std::size_t{0});
+}
+}  // namespace lox
+
+#endif  // LOX_AST_COUNT_H
@@ -2,26 +2,37 @@
 #if !defined(LOX_AST_EXPRESSION_H)
 #define LOX_AST_EXPRESSION_H
 
-#include <memory>
+#include <gsl/span>
+
+#include <optional>
 
 #include "lox/ast/visitor.hpp"
+#include "lox/environment.hpp"
 #include "lox/token.hpp"
+#include "lox/value.hpp"
 
 namespace lox
 {
+// Nodes are allocated in the Arena owned by their Program and are never deleted individually, so
+// children are non-owning pointers and only nodes with non-trivial members need destroying. Members
+// marked mutable are filled in by the resolver once the program has been parsed.
+// Members narrower than a pointer come first, so they share the padding after m_line.
 struct Expression
 {
-  virtual ~Expression() = default;
   virtual auto accept(AstVisitor& visitor) const -> result<void> = 0;
   virtual auto is_lvalue() const -> std::optional<Token> = 0;
   auto is_rvalue() const -> bool { return !is_lvalue(); }
+
+  // Source line the node was parsed from
+  std::uint32_t m_line = 0;
+
+protected:
+  ~Expression() = default;
 };
 
 template <typename T>
 struct ExpressionBase : public Expression
 {
-  virtual ~ExpressionBase() = default;
-
   virtual auto accept(AstVisitor& visitor) const -> result<void> override
   {
     return visitor.visit(static_cast<T const&>(*this));
@@ -31,12 +42,11 @@ struct ExpressionBase : public Expression
 
 struct Definition final : public ExpressionBase<Definition>
 {
-  Definition(Token name, std::unique_ptr<Expression> value)
-    : m_name(std::move(name)), m_value(std::move(value))
-  {
-  }
+  Definition(Token name, Expression const* value) : m_name(std::move(name)), m_value(value) {}
+  // Index of the variable in the enclosing scope
+  mutable std::uint32_t m_slot = 0;
   Token m_name;
-  std::unique_ptr<Expression> m_value;
+  Expression const* m_value;
 };
 
 struct Read final : public ExpressionBase<Read>
@@ -45,65 +55,63 @@ struct Read final : public ExpressionBase<Read>
   virtual auto is_lvalue() const -> std::optional<Token> override { return m_name; }
 
   Token m_name;
+  mutable Binding m_binding;
 };
 
 struct Statement final : public ExpressionBase<Statement>
 {
-  Statement(std::unique_ptr<Expression> expression) : m_expression(std::move(expression)) {}
-  std::unique_ptr<Expression> m_expression;
+  Statement(Expression const* expression) : m_expression(expression) {}
+  Expression const* m_expression;
 };
 
 struct Block final : public ExpressionBase<Block>
 {
-  Block(std::vector<std::unique_ptr<Expression>>&& expressions) : m_expressions(std::move(expressions))
-  {}
-  std::vector<std::unique_ptr<Expression>> m_expressions;
+  Block(gsl::span<Expression const* const> expressions) : m_expressions(expressions) {}
+  // Number of distinct variables declared directly in the block
+  mutable std::uint32_t m_size = 0;
+  gsl::span<Expression const* const> m_expressions;
 };
 
 struct Print final : public ExpressionBase<Print>
 {
-  Print(std::unique_ptr<Expression> value) : m_value(std::move(value)) {}
-  std::unique_ptr<Expression> m_value;
+  Print(Expression const* value) : m_value(value) {}
+  Expression const* m_value;
 };
 
 struct Assign final : public ExpressionBase<Assign>
 {
-  Assign(Token name, std::unique_ptr<Expression> value)
-    : m_name(std::move(name)), m_value(std::move(value))
-  {
-  }
+  Assign(Token name, Expression const* value) : m_name(std::move(name)), m_value(value) {}
   Token m_name;
-  std::unique_ptr<Expression> m_value;
+  Expression const* m_value;
+  mutable Binding m_binding;
 };
 
 struct Ternary final : public ExpressionBase<Ternary>
 {
-  Ternary(std::unique_ptr<Expression> cond,
-          std::unique_ptr<Expression> left,
-          std::unique_ptr<Expression> right)
-    : m_cond(std::move(cond)), m_left(std::move(left)), m_right(std::move(right))
+  Ternary(Expression const* cond, Expression const* left, Expression const* right)
+    : m_cond(cond), m_left(left), m_right(right)
   {
   }
-  std::unique_ptr<Expression> m_cond;
-  std::unique_ptr<Expression> m_left;
-  std::unique_ptr<Expression> m_right;
+  Expression const* m_cond;
+  Expression const* m_left;
+  Expression const* m_right;
 };
 
 struct Binary final : public ExpressionBase<Binary>
 {
-  Binary(std::unique_ptr<Expression> left, std::unique_ptr<Expression> right, TOKEN_TYPE op)
-    : m_left(std::move(left)), m_right(std::move(right)), m_op(std::move(op))
+  Binary(Expression const* left, Expression const* right, TOKEN_TYPE op)
+    : m_op(std::move(op)), m_left(left), m_right(right)
   {
   }
-  std::unique_ptr<Expression> m_left;
-  std::unique_ptr<Expression> m_right;
   TOKEN_TYPE m_op;
+  Expression const* m_left;
+  Expression const* m_right;
 };
 
 struct Group final : public ExpressionBase<Group>
 {
-  Group(std::unique_ptr<Expression> expr) : m_expression(std::move(expr)) {}
-  std::unique_ptr<Expression> m_expression;
+  Group(Expression const* expr) : m_expression(expr) {}
+  Expression const* m_expression;
 };
 
 struct Literal final : public ExpressionBase<Literal>
@@ -112,19 +120,15 @@ struct Literal final : public ExpressionBase<Literal>
   Literal(T&& val) : m_literal(std::forward<T>(val))
   {
   }
-  Token::literal m_literal;
+  Value m_literal;
 };
 
 struct Unary final : public ExpressionBase<Unary>
 {
-  Unary(std::unique_ptr<Expression> expr, TOKEN_TYPE op)
-    : m_expression(std::move(expr)), m_op(std::move(op))
-  {
-  }
-  std::unique_ptr<Expression> m_expression;
+  Unary(Expression const* expr, TOKEN_TYPE op) : m_op(std::move(op)), m_expression(expr) {}
   TOKEN_TYPE m_op;
+  Expression const* m_expression;
 };
 }  // namespace lox
 
 #endif  // LOX_AST_EXPRESSION_H
-
@@ -2,6 +2,8 @@
 #if !defined(LOX_AST_EXPRESSION_FWD_H)
 #define LOX_AST_EXPRESSION_FWD_H
 
+#include <cstdint>
+
 namespace lox
 {
 // Forward decl
@@ -16,6 +18,22 @@ struct Binary;
 struct Group;
 struct Literal;
 struct Unary;
+
+/// Kind of each node, mirroring the Expression hierarchy
+enum class NODE_KIND : uint8_t
+{
+  DEFINITION,
+  READ,
+  STATEMENT,
+  BLOCK,
+  PRINT,
+  ASSIGN,
+  TERNARY,
+  BINARY,
+  GROUP,
+  LITERAL,
+  UNARY,
+};
 }
 
 #endif // LOX_AST_EXPRESSION_FWD_H
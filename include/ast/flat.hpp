@@ -0,0 +1,57 @@
+#pragma once
+#if !defined(LOX_AST_FLAT_H)
+#define LOX_AST_FLAT_H
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include "lox/ast/parse.hpp"
+#include "lox/string_pool.hpp"
+#include "lox/token.hpp"
+#include "lox/value.hpp"
+
+namespace lox
+{
+/// Index of a node in a FlatAst
+using NodeIndex = std::uint32_t;
+
+/// A program stored as parallel arrays indexed by NodeIndex, with nodes laid out in the order they
+/// are evaluated. What each node's operands and payload hold depends on its kind:
+///   DEFINITION:         payload is the name's symbol, operand 0 is the value and 1 the slot
+///   ASSIGN:             payload is the name's symbol, operand 0 is the value and 1 indexes m_bindings
+///   READ:               payload is the name's symbol, operand 0 indexes m_bindings
+///   STATEMENT, PRINT, GROUP, UNARY: operand 0 is the child
+///   BINARY:             operand 0 and 1 are the left and right children
+///   TERNARY:            operand 0 is the condition, 1 the true branch and payload the false branch
+///   BLOCK:              operands are the offset and count of its children in m_lists, payload is
+///                       the number of variables it declares
+///   LITERAL:            the operator is the literal's token type. Payload holds the bits of a NUMBER
+///                       or the index of a STRING in m_strings.
+struct FlatAst
+{
+  auto size() const -> std::size_t { return m_kinds.size(); }
+
+  /// Bytes used by the node arrays and their side tables
+  auto size_bytes() const -> std::size_t;
+
+  std::vector<NODE_KIND> m_kinds;
+  std::vector<TOKEN_TYPE> m_ops;
+  std::vector<std::array<NodeIndex, 2>> m_operands;
+  std::vector<std::uint32_t> m_payloads;
+  // Children of every block, contiguously
+  std::vector<NodeIndex> m_lists;
+  std::vector<Value> m_strings;
+  // Resolved variable accesses, which point into the program's arena so it must outlive the tree
+  std::vector<Binding> m_bindings;
+  // The top level declarations, in program order
+  std::vector<NodeIndex> m_roots;
+  // Resolves the symbols used as names, must outlive the tree
+  StringPool const* m_names = nullptr;
+};
+
+/// Build a flat copy of a parsed and resolved program, whose names were interned in pool
+auto flatten(Program const& program, StringPool const* pool) -> FlatAst;
+}  // namespace lox
+
+#endif  // LOX_AST_FLAT_H
@@ -0,0 +1,22 @@
+#pragma once
+#if !defined(LOX_AST_FLAT_INTERPRETER_H)
+#define LOX_AST_FLAT_INTERPRETER_H
+
+#include "lox/ast/flat.hpp"
+#include "lox/environment.hpp"
+
+namespace lox
+{
+/// Evaluates a FlatAst, producing exactly the same results and errors as Interpreter does on the
+/// tree it was built from
+struct FlatInterpreter
+{
+  /// Evaluate node and its children, leaving the value in result
+  auto evaluate(FlatAst const& ast, NodeIndex node) -> lox::result<void>;
+
+  Environment environment;
+  Value result;
+};
+}  // namespace lox
+
+#endif  // LOX_AST_FLAT_INTERPRETER_H
@@ -0,0 +1,20 @@
+#pragma once
+#if !defined(LOX_AST_OPTIMIZE_H)
+#define LOX_AST_OPTIMIZE_H
+
+#include <cstddef>
+
+#include "lox/ast/parse.hpp"
+
+namespace lox
+{
+/// Simplify a parsed program without changing what it prints or which errors it raises: operators
+/// over literals are folded, groups are unwrapped and ternaries with literal conditions are replaced
+/// by the branch they take. Operations which would fail are left to fail at runtime. Rewritten nodes
+/// are allocated in the program's arena, and the program must be resolved afterwards.
+///
+/// Returns the number of nodes removed.
+auto optimize(Program* program) -> std::size_t;
+}  // namespace lox
+
+#endif  // LOX_AST_OPTIMIZE_H
@@ -2,65 +2,74 @@
 #if !defined(LOX_AST_PARSE_H)
 #define LOX_AST_PARSE_H
 
-#include <gsl/span>
 #include <tuple>
+#include <vector>
 
+#include "lox/arena.hpp"
 #include "lox/ast/expression.hpp"
 #include "lox/error.hpp"
 #include "lox/token.hpp"
+#include "lox/token_stream.hpp"
 
 namespace lox
 {
-using parse_list_result = result<std::vector<std::unique_ptr<Expression>>>;
-using parse_result = result<std::tuple<std::unique_ptr<Expression>, gsl::span<Token>>>;
+/// A list of instructions, along with the arena which owns every node in them
+struct Program
+{
+  Arena m_arena;
+  std::vector<Expression const*> m_expressions;
+};
+
+using parse_list_result = result<Program>;
+using parse_result = result<std::tuple<Expression const*, TokenCursor>>;
 
-/// Parse a list of tokens to produce a list of instructions
-auto parse(gsl::span<Token> tokens) -> parse_list_result;
+/// Parse a stream of tokens to produce a list of instructions
+auto parse(TokenStream& tokens) -> parse_list_result;
 
 /// declaration -> definition | statement
-auto parse_declaration(gsl::span<Token> tokens) -> parse_result;
+auto parse_declaration(TokenCursor tokens, Arena* arena) -> parse_result;
 
 /// definition -> "var" IDENTIFIER ("=" expression)? ";"
-auto parse_definition(gsl::span<Token> tokens) -> parse_result;
+auto parse_definition(TokenCursor tokens, Arena* arena) -> parse_result;
 
 /// statement -> ((expression | print) ";") | block
-auto parse_statement(gsl::span<Token> tokens) -> parse_result;
+auto parse_statement(TokenCursor tokens, Arena* arena) -> parse_result;
 
 /// block -> "{" declaration* expression? "}"
-auto parse_block(gsl::span<Token> tokens) -> parse_result;
+auto parse_block(TokenCursor tokens, Arena* arena) -> parse_result;
 
 /// print -> "print" expression ";"
-auto parse_print(gsl::span<Token> tokens) -> parse_result;
+auto parse_print(TokenCursor tokens, Arena* arena) -> parse_result;
 
 /// expression -> list
-auto parse_expression(gsl::span<Token> tokens) -> parse_result;
+auto parse_expression(TokenCursor tokens, Arena* arena) -> parse_result;
 
 /// list -> assignment ("," assignment)*
-auto parse_list(gsl::span<Token> tokens) -> parse_result;
+auto parse_list(TokenCursor tokens, Arena* arena) -> parse_result;
 
 /// assignment -> IDENTIFIER "=" assignment | ternary | block
-auto parse_assignment(gsl::span<Token> tokens) -> parse_result;
+auto parse_assignment(TokenCursor tokens, Arena* arena) -> parse_result;
 
 /// ternary -> equality ("?" ternary ":" ternary)*
-auto parse_ternary(gsl::span<Token> tokens) -> parse_result;
+auto parse_ternary(TokenCursor tokens, Arena* arena) -> parse_result;
 
 /// equality -> comparison (("!=" | "==") comparison)*
-auto parse_equality(gsl::span<Token> tokens) -> parse_result;
+auto parse_equality(TokenCursor tokens, Arena* arena) -> parse_result;
 
 /// comparison -> addition ((">" | ">=" | "<" | "<=") addition)*
-auto parse_comparison(gsl::span<Token> tokens) -> parse_result;
+auto parse_comparison(TokenCursor tokens, Arena* arena) -> parse_result;
 
 /// addition -> multiplication (("-" | "+") multiplication)*
-auto parse_addition(gsl::span<Token> tokens) -> parse_result;
+auto parse_addition(TokenCursor tokens, Arena* arena) -> parse_result;
 
 /// multiplication -> unary (("/" | "*") unary)*
-auto parse_multiplication(gsl::span<Token> tokens) -> parse_result;
+auto parse_multiplication(TokenCursor tokens, Arena* arena) -> parse_result;
 
 /// unary -> ("!" | "-") unary | primary
-auto parse_unary(gsl::span<Token> tokens) -> parse_result;
+auto parse_unary(TokenCursor tokens, Arena* arena) -> parse_result;
 
 /// primary -> NUMBER | STRING | "false" | "true" | "nil" | "(" expression ")" | IDENTIFIER
-auto parse_primary(gsl::span<Token> tokens) -> parse_result;
+auto parse_primary(TokenCursor tokens, Arena* arena) -> parse_result;
 }  // namespace lox
 
 #endif  // LOX_AST_PARSE_H
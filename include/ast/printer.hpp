@@ -5,7 +5,7 @@
 #include <magic_enum/magic_enum.hpp>
 
 #include "lox/ast/expression.hpp"
-#include "lox/literal_to_string.hpp"
+#include "lox/value.hpp"
 
 namespace lox
 {
@@ -64,7 +64,7 @@ struct AstPrinter final : public AstVisitor
   }
   virtual auto visit(Literal const& expr) -> result<void> override
   {
-    m_ast += std::visit(LiteralToString{}, expr.m_literal);
+    m_ast += to_string(expr.m_literal);
     return lox::ok();
   }
   virtual auto visit(Unary const& expr) -> result<void> override
@@ -0,0 +1,95 @@
+#pragma once
+#if !defined(LOX_AST_PROFILER_H)
+#define LOX_AST_PROFILER_H
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <magic_enum/magic_enum.hpp>
+
+#include "lox/ast/expression.hpp"
+#include "lox/error.hpp"
+
+namespace lox
+{
+/// Interpreter hooks counting how often each kind of node and each source line is executed, and the
+/// wall time spent in them excluding the time spent in their children
+struct Profiler
+{
+  using clock = std::chrono::steady_clock;
+
+  struct Sample
+  {
+    std::uint64_t m_count = 0;
+    clock::duration m_time{};
+  };
+
+  // Records the node entered when it was made once it is destroyed
+  struct Scope
+  {
+    explicit Scope(Profiler* profiler) : m_profiler(profiler) {}
+    Scope(Scope const&) = delete;
+    auto operator=(Scope const&) -> Scope& = delete;
+    ~Scope() { m_profiler->leave(); }
+
+    Profiler* m_profiler;
+  };
+
+  auto enter(Expression const& expr, NODE_KIND kind) -> Scope
+  {
+    m_stack.push_back(Frame{kind, expr.m_line, clock::now(), {}});
+    return Scope{this};
+  }
+
+  auto leave() -> void
+  {
+    auto const frame = m_stack.back();
+    auto const elapsed = clock::now() - frame.m_start;
+    auto const self = elapsed - frame.m_children;
+    auto& kind = m_kinds[magic_enum::enum_integer(frame.m_kind)];
+    ++kind.m_count;
+    kind.m_time += self;
+    auto& line = m_lines[frame.m_line];
+    ++line.m_count;
+    line.m_time += self;
+    if (m_collect_stacks) record_stack(self);
+    m_stack.pop_back();
+    if (!m_stack.empty()) m_stack.back().m_children += elapsed;
+  }
+
+  /// Print the node kinds and the lines which took the most time, hottest first
+  auto report(std::size_t lines) const -> void;
+
+  /// Write the time spent in each distinct stack of nodes as collapsed stacks, one per line, which
+  /// flamegraph tools read. Only stacks recorded while m_collect_stacks was set are written.
+  auto write_stacks(std::filesystem::path const& path) const -> result<void>;
+
+  std::array<Sample, magic_enum::enum_count<NODE_KIND>()> m_kinds{};
+  std::unordered_map<std::uint32_t, Sample> m_lines;
+  // Self time of each stack of nodes, keyed by its collapsed form
+  bool m_collect_stacks = false;
+  std::unordered_map<std::string, clock::duration> m_stacks;
+
+private:
+  struct Frame
+  {
+    NODE_KIND m_kind;
+    std::uint32_t m_line;
+    clock::time_point m_start;
+    // Total time of the children which have finished, to be excluded from this node's
+    clock::duration m_children;
+  };
+
+  auto record_stack(clock::duration self) -> void;
+
+  // The nodes currently being executed, outermost first
+  std::vector<Frame> m_stack;
+};
+}  // namespace lox
+
+#endif  // LOX_AST_PROFILER_H
@@ -0,0 +1,26 @@
+#pragma once
+#if !defined(LOX_AST_RESOLVE_H)
+#define LOX_AST_RESOLVE_H
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+
+#include "lox/ast/parse.hpp"
+
+namespace lox
+{
+/// Gives every variable a slot in the scope declaring it, and binds each Read and Assign to the
+/// slots it may refer to. Globals are remembered between programs, so that later lines in a REPL
+/// can refer to variables declared on earlier ones.
+struct Resolver
+{
+  /// Annotate a parsed program, must be called before it is executed or lowered
+  auto resolve(Program* program) -> void;
+
+  // Slot of each global, keyed by name as every program has its own StringPool
+  std::unordered_map<std::string, std::uint32_t> m_globals;
+};
+}  // namespace lox
+
+#endif  // LOX_AST_RESOLVE_H
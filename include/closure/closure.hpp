@@ -0,0 +1,43 @@
+#pragma once
+#if !defined(LOX_CLOSURE_CLOSURE_H)
+#define LOX_CLOSURE_CLOSURE_H
+
+#include <functional>
+#include <vector>
+
+#include "lox/environment.hpp"
+#include "lox/error.hpp"
+#include "lox/value.hpp"
+
+namespace lox
+{
+struct ClosureInterpreter;
+
+/// An expression compiled to a callable which evaluates it, leaving its value in the interpreter's
+/// result. Each node kind and operator gets its own callable, so nothing is dispatched on at runtime
+/// other than the call itself.
+using Closure = std::function<lox::result<void>(ClosureInterpreter&)>;
+
+/// A program compiled to closures. Names and bindings refer into the source and program they were
+/// compiled from, which must outlive it.
+struct ClosureProgram
+{
+  // One closure per top level declaration
+  std::vector<Closure> m_roots;
+};
+
+/// Executes compiled closures, producing exactly the same output and errors as Interpreter
+struct ClosureInterpreter
+{
+  /// Execute a top level declaration of program, leaving its value in result
+  auto run(ClosureProgram const& program, std::size_t root) -> lox::result<void>
+  {
+    return program.m_roots[root](*this);
+  }
+
+  Environment environment;
+  Value result;
+};
+}  // namespace lox
+
+#endif  // LOX_CLOSURE_CLOSURE_H
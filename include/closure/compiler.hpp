@@ -0,0 +1,14 @@
+#pragma once
+#if !defined(LOX_CLOSURE_COMPILER_H)
+#define LOX_CLOSURE_COMPILER_H
+
+#include "lox/ast/parse.hpp"
+#include "lox/closure/closure.hpp"
+
+namespace lox
+{
+/// Compile a parsed and resolved program to closures, with one per top level declaration
+auto compile_closures(Program const& program) -> ClosureProgram;
+}  // namespace lox
+
+#endif  // LOX_CLOSURE_COMPILER_H
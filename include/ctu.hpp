@@ -7,17 +7,18 @@
 
 namespace ctu
 {
+// Helper to get a string literal from a std::array
+template <std::size_t N, std::array<char, N> const& S, typename>
+struct to_char_array;
+template <std::size_t N, std::array<char, N> const& S, std::size_t... I>
+struct to_char_array<N, S, std::index_sequence<I...>>
+{
+  static constexpr const char value[]{S[I]..., 0};
+};
+
 template <std::string_view const&... Strs>
 struct join
 {
-  // Helper to get a string literal from a std::array
-  template <std::size_t N, std::array<char, N> const& S, typename>
-  struct to_char_array;
-  template <std::size_t N, std::array<char, N> const& S, std::size_t... I>
-  struct to_char_array<N, S, std::index_sequence<I...>>
-  {
-    static constexpr const char value[]{S[I]..., 0};
-  };
   // Join all strings into a single std::array of chars
   static constexpr auto impl() noexcept
   {
@@ -41,6 +42,28 @@ static constexpr auto join_v = join<Strs...>::value;
 // Helpers to get a string literal out
 template <std::string_view const&... Strs>
 using join_l = typename join<Strs...>::literal;
+
+template <std::string_view const& Str>
+struct lower
+{
+  // Copy the string, converting any ASCII upper case characters
+  static constexpr auto impl() noexcept
+  {
+    std::array<char, Str.size()> arr{};
+    for (std::size_t i = 0; i < Str.size(); ++i)
+    {
+      arr[i] = Str[i] >= 'A' && Str[i] <= 'Z' ? Str[i] - 'A' + 'a' : Str[i];
+    }
+    return arr;
+  }
+  // Give the converted string static storage
+  static constexpr auto arr = impl();
+  using literal = to_char_array<arr.size(), arr, std::make_index_sequence<arr.size()>>;
+  static constexpr std::string_view value = literal::value;
+};
+// Helper to get the value out
+template <std::string_view const& Str>
+static constexpr auto lower_v = lower<Str>::value;
 }  // namespace ctu
 
 #endif  // COMPILE_TIME_UTILS_H
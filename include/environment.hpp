@@ -2,81 +2,111 @@
 #if !defined(LOX_ENVIRONMENT_H)
 #define LOX_ENVIRONMENT_H
 
+#include <gsl/span>
+
+#include <cstdint>
 #include <string_view>
-#include <unordered_map>
+#include <vector>
 #include <fmt/format.h>
 #include "lox/error.hpp"
-#include "lox/token.hpp"
+#include "lox/value.hpp"
 
 namespace lox
 {
-struct Key
+/// Where a variable lives: the number of scopes outwards from the one accessing it, and its index
+/// within that scope
+struct Slot
 {
-  std::string name;
-  auto operator==(Key const& rhs) const -> bool
-  {
-    return name == rhs.name;
-  }
+  std::uint32_t m_depth;
+  std::uint32_t m_index;
 };
-}
-
-namespace std
-{
-template<>
-struct hash<lox::Key>
-{
-  auto operator()(lox::Key const& key) const -> std::size_t
-  {
-    return std::hash<std::string>{}(key.name);
-  }
-};
-}
 
+/// Every declaration an access may refer to, innermost first. Only the first is normally used,
+/// the rest are fallen back on when a declaration didn't execute because its value failed. Empty
+/// when no declaration of the name is visible.
+using Binding = gsl::span<Slot const>;
 
-namespace lox
-{
+/// Variables stored in one contiguous array, with a frame of fixed size for each scope. The resolver
+/// has already decided which slot every access refers to, so nothing is hashed at runtime.
 struct Environment
 {
   struct Value
   {
-    Token::literal value;
+    lox::Value value;
   };
 
-  auto current_scope() -> std::unordered_map<Key, Value>&
+  // Held by slots whose declaration hasn't executed, a NaN payload no Value uses
+  static constexpr std::uint64_t undefined_bits = lox::Value::quiet_nan | 4;
+  // Initial capacity, so that typical nesting never has to grow the stacks
+  static constexpr std::size_t initial_slots = 256;
+  static constexpr std::size_t initial_frames = 32;
+
+  Environment()
   {
-    return scopes.back();
+    m_slots.reserve(initial_slots);
+    m_frames.reserve(initial_frames);
   }
 
-  auto lookup(Key const& key) -> result<Value*>
+  auto lookup(Binding binding, std::string_view name) -> result<Value*>
   {
-    // Reverse search through the scopes until the key is found
-    for (auto it = scopes.rbegin(); it != scopes.rend(); ++it)
+    // Fall outwards past declarations which haven't been executed
+    for (auto const& slot : binding)
     {
-      // If the scope has our key, return the associated value
-      if (auto val = it->find(key); val != it->end()) return &val->second;
+      auto const frame = m_frames.size() - 1 - slot.m_depth;
+      auto const first = m_frames[frame];
+      auto const last = frame + 1 == m_frames.size() ? m_slots.size() : m_frames[frame + 1];
+      // Globals declared since the last global definition ran may be past the end of their frame
+      if (slot.m_index >= last - first) continue;
+      auto& value = m_slots[first + slot.m_index];
+      if (value.value.m_bits != undefined_bits) return &value;
     }
-    return lox::error(fmt::format("Undefined variable '{}'.", key.name), ~0u);
+    return lox::error(fmt::format("Undefined variable '{}'.", name), ~0u);
   }
 
-  auto define(Key const& key, Value const& value) -> void
+  /// Define the variable at index in the innermost scope
+  auto define(std::uint32_t index, Value const& value) -> void
   {
-    current_scope()[key] = value;
+    auto const slot = m_frames.back() + index;
+    // Only the global scope grows, blocks are pushed with room for all of their variables
+    if (slot >= m_slots.size()) resize(slot + 1);
+    m_slots[slot] = value;
   }
 
-  auto assign(Key const& key, Value const& value) -> result<void>
+  auto assign(Binding binding, std::string_view name, Value const& value) -> result<void>
   {
-    auto val = lookup(key);
+    auto val = lookup(binding, name);
     if (!val) return lox::error(val.error());
     **val = value;
     return lox::ok();
   }
 
-  auto push_scope() -> void { scopes.emplace_back(); }
+  /// Enter a scope declaring size variables. The stacks only shrink logically when a scope is left,
+  /// so once they have grown to the deepest nesting seen, entering and leaving allocates nothing.
+  auto push_scope(std::uint32_t size) -> void
+  {
+    m_frames.push_back(m_slots.size());
+    resize(m_slots.size() + size);
+  }
+
+  auto pop_scope() -> void
+  {
+    if (m_frames.size() <= 1) return;
+    m_slots.resize(m_frames.back());
+    m_frames.pop_back();
+  }
 
-  auto pop_scope() -> void { if (!scopes.empty()) scopes.pop_back(); }
+  // Values of every variable in scope, outermost scope first
+  std::vector<Value> m_slots;
+  // Offset of each scope's first slot, starting with the global scope
+  std::vector<std::size_t> m_frames{0};
 
-  // Stack of scopes, default construct with a single scope
-  std::vector<std::unordered_map<Key, Value>> scopes{{}};
+private:
+  auto resize(std::size_t size) -> void
+  {
+    Value undefined;
+    undefined.value.m_bits = undefined_bits;
+    m_slots.resize(size, undefined);
+  }
 };
 }
 
@@ -2,15 +2,38 @@
 #if !defined(LOX_ERROR_H)
 #define LOX_ERROR_H
 
+#include <cstdint>
 #include <string>
+#include <string_view>
 #include <tl/expected.hpp>
 
 namespace lox
 {
+/// What went wrong. Errors which scripts may raise at runtime over and over, such as type errors,
+/// carry a code instead of a message so that raising one never allocates. They are only described
+/// when reported.
+enum class ERROR_CODE : uint8_t
+{
+  // Described by the message
+  MESSAGE,
+  MISMATCHED_TYPES,
+  EXPECTED_NUMBERS,
+  EXPECTED_NUMBER_OPERAND,
+  DIVISION_BY_ZERO,
+  UNHANDLED_BINARY,
+  UNHANDLED_UNARY,
+};
+
 struct Error final
 {
   std::string message;
   std::size_t line;
+  ERROR_CODE code = ERROR_CODE::MESSAGE;
+  // Name of the operator which raised a coded error
+  std::string_view op = {};
+
+  /// The message, or the description of a coded error
+  auto describe() const -> std::string;
 };
 
 auto report(Error const& error) -> void;
@@ -24,6 +47,12 @@ inline auto error(Ts&&... xs) noexcept
   return tl::make_unexpected(Error{std::forward<Ts>(xs)...});
 }
 
+/// An error raised by the operator named op, which doesn't allocate
+inline auto operator_error(ERROR_CODE code, std::string_view op) noexcept
+{
+  return tl::make_unexpected(Error{{}, ~0u, code, op});
+}
+
 inline auto ok() noexcept -> result<void> { return {}; }
 }  // namespace lox
 #endif  // LOX_ERROR_H
@@ -0,0 +1,105 @@
+#pragma once
+#if !defined(LOX_KEYWORD_H)
+#define LOX_KEYWORD_H
+
+#include <array>
+#include <cstdint>
+#include <magic_enum/magic_enum.hpp>
+#include <string_view>
+
+#include "lox/ctu.hpp"
+#include "lox/token.hpp"
+
+namespace lox
+{
+namespace keyword
+{
+// Keywords occupy a contiguous range of token types
+constexpr auto first = TOKEN_TYPE::AND;
+constexpr auto last = TOKEN_TYPE::WHILE;
+constexpr std::size_t count = magic_enum::enum_integer(last) - magic_enum::enum_integer(first) + 1;
+
+constexpr auto contains(TOKEN_TYPE type) -> bool { return type >= first && type <= last; }
+
+// The source spelling of a keyword is the lower case name of its token type
+template <TOKEN_TYPE Type>
+constexpr std::string_view name = magic_enum::enum_name<Type>();
+template <TOKEN_TYPE Type>
+constexpr std::string_view spelling = ctu::lower_v<name<Type>>;
+
+struct Entry
+{
+  std::string_view spelling;
+  TOKEN_TYPE type = TOKEN_TYPE::IDENTIFIER;
+};
+
+// Every keyword is distinguished by its first character, last character and length, so we only need
+// to find multipliers which spread those over the table without collisions
+constexpr std::size_t table_size = 32;
+constexpr auto hash(std::string_view word, std::uint32_t seed) -> std::size_t
+{
+  auto const front = static_cast<std::uint8_t>(word.front());
+  auto const back = static_cast<std::uint8_t>(word.back());
+  return (front * (seed & 0xff) + back * (seed >> 8) + word.size()) % table_size;
+}
+
+template <std::size_t... I>
+constexpr auto make_entries(std::index_sequence<I...>)
+{
+  return std::array<Entry, count>{
+    Entry{spelling<magic_enum::enum_value<TOKEN_TYPE>(magic_enum::enum_integer(first) + I)>,
+          magic_enum::enum_value<TOKEN_TYPE>(magic_enum::enum_integer(first) + I)}...};
+}
+constexpr auto entries = make_entries(std::make_index_sequence<count>{});
+
+// Search for the first seed which places every keyword in its own slot
+constexpr auto find_seed() -> std::uint32_t
+{
+  for (std::uint32_t seed = 0x0101;; ++seed)
+  {
+    std::array<bool, table_size> used{};
+    bool perfect = true;
+    for (auto const& entry : entries)
+    {
+      auto const slot = hash(entry.spelling, seed);
+      perfect = perfect && !used[slot];
+      used[slot] = true;
+    }
+    if (perfect) return seed;
+  }
+}
+constexpr std::uint32_t seed = find_seed();
+
+constexpr auto make_table()
+{
+  std::array<Entry, table_size> table{};
+  for (auto const& entry : entries) table[hash(entry.spelling, seed)] = entry;
+  return table;
+}
+constexpr auto table = make_table();
+
+// Bounds on keyword length allow most identifiers to be rejected before hashing
+constexpr auto length_bounds()
+{
+  std::array<std::size_t, 2> bounds{~std::size_t{0}, 0};
+  for (auto const& entry : entries)
+  {
+    if (entry.spelling.size() < bounds[0]) bounds[0] = entry.spelling.size();
+    if (entry.spelling.size() > bounds[1]) bounds[1] = entry.spelling.size();
+  }
+  return bounds;
+}
+constexpr auto min_length = length_bounds()[0];
+constexpr auto max_length = length_bounds()[1];
+}  // namespace keyword
+
+/// Classify a scanned identifier as either a keyword, or a plain IDENTIFIER
+constexpr auto classify_identifier(std::string_view word) -> TOKEN_TYPE
+{
+  if (word.size() < keyword::min_length || word.size() > keyword::max_length) return TOKEN_TYPE::IDENTIFIER;
+  auto const& entry = keyword::table[keyword::hash(word, keyword::seed)];
+  return entry.spelling == word ? entry.type : TOKEN_TYPE::IDENTIFIER;
+}
+}  // namespace lox
+
+#endif  // LOX_KEYWORD_H
@@ -3,11 +3,38 @@
 #define LOX_LEX_H
 
 #include "lox/error.hpp"
+#include "lox/string_pool.hpp"
 #include "lox/token.hpp"
 #include <string_view>
 
 namespace lox
 {
-auto lex(std::string_view source) -> lox::result<std::vector<Token>>;
+/// Implementation used to split source text into tokens, both produce identical token lists
+enum class LEX_BACKEND : uint8_t
+{
+  // A single ctre alternation of every token pattern
+  REGEX,
+  // Hand-written scanner which branches on the first character of each token
+  SCANNER,
+};
+
+/// Lex the first token in source, skipping any leading whitespace. Produces an END token when only
+/// whitespace remains. Advances source past the token, and line past any newlines consumed. Strings
+/// and identifiers are interned into pool.
+auto lex_token(std::string_view* source,
+               std::uint32_t* line,
+               StringPool* pool,
+               LEX_BACKEND backend = LEX_BACKEND::SCANNER) -> lox::result<Token>;
+
+/// Lex the whole of source
+auto lex(std::string_view source, StringPool* pool, LEX_BACKEND backend = LEX_BACKEND::SCANNER)
+  -> lox::result<std::vector<Token>>;
+
+/// Lex the whole of source using up to threads threads, each lexing a run of whole lines. Produces
+/// exactly the same tokens, symbols and errors as lex(). Small sources are lexed sequentially.
+auto lex_parallel(std::string_view source,
+                  StringPool* pool,
+                  std::size_t threads,
+                  LEX_BACKEND backend = LEX_BACKEND::SCANNER) -> lox::result<std::vector<Token>>;
 }
 #endif // LOX_LEX_H
@@ -0,0 +1,69 @@
+#pragma once
+#if !defined(LOX_MEMORY_STATS_H)
+#define LOX_MEMORY_STATS_H
+
+#include <cstdint>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "lox/allocation.hpp"
+#include "lox/ast/count.hpp"
+#include "lox/environment.hpp"
+
+namespace lox
+{
+/// A tracer which, instead of timing each phase, counts the allocations made during it. Also keeps
+/// the size of every program it is shown, for a breakdown of where memory goes.
+struct MemoryStats
+{
+  static constexpr bool enabled = true;
+
+  // Adds what was allocated during its lifetime to its phase
+  struct Span
+  {
+    Span(MemoryStats* stats, std::string_view name) : m_stats(stats), m_name(name) {}
+    Span(Span const&) = delete;
+    auto operator=(Span const&) -> Span& = delete;
+    ~Span() { m_stats->record(m_name, m_scope.stats()); }
+
+    MemoryStats* m_stats;
+    std::string_view m_name;
+    AllocationScope m_scope;
+  };
+
+  struct Phase
+  {
+    std::uint64_t m_spans = 0;
+    AllocationStats m_allocated;
+  };
+
+  auto span(std::string_view name, std::uint32_t = 0) -> Span { return Span{this, name}; }
+
+  /// Counters are summed over every run
+  auto counter(std::string_view name, double value) -> void;
+
+  auto program(Program const& program) -> void;
+
+  /// Lexing is done by the parser's token stream, so is recorded as a phase once parsing is done
+  auto lexed(TokenStream const& tokens) -> void;
+
+  /// Add what was allocated during one span of a phase
+  auto record(std::string_view name, AllocationStats allocated) -> void;
+
+  /// Print the allocations of each phase, the size of the programs and of environment, and the
+  /// peak resident size of the process
+  auto report(Environment const& environment) const -> void;
+
+  // In the order each was first seen, names must be string literals
+  std::vector<std::pair<std::string_view, Phase>> m_phases;
+  std::vector<std::pair<std::string_view, double>> m_counters;
+  NodeCounts m_nodes{};
+  // Most tokens any token stream buffered at once
+  std::size_t m_peak_tokens = 0;
+  // Bytes reserved by the arenas of every program
+  std::size_t m_arena_bytes = 0;
+};
+}  // namespace lox
+
+#endif  // LOX_MEMORY_STATS_H
@@ -0,0 +1,26 @@
+#pragma once
+#if !defined(LOX_OPERATORS_H)
+#define LOX_OPERATORS_H
+
+#include "lox/error.hpp"
+#include "lox/token.hpp"
+#include "lox/value.hpp"
+
+namespace lox
+{
+/// Whether a value is considered true in a condition
+struct Truth
+{
+  auto operator()(Value const& v) const -> bool { return v.is_bool() ? v.as_bool() : !v.is_nil(); }
+};
+
+/// Apply a binary operator to evaluated operands, shared by every evaluator so they agree exactly.
+/// Dispatches through a table indexed by the operator and both operand types, so type errors are
+/// reported without throwing.
+auto binary(TOKEN_TYPE op, Value const& lhs, Value const& rhs) -> result<Value>;
+
+/// Apply a unary operator to an evaluated operand
+auto unary(TOKEN_TYPE op, Value const& operand) -> result<Value>;
+}  // namespace lox
+
+#endif  // LOX_OPERATORS_H
@@ -0,0 +1,40 @@
+#pragma once
+#if !defined(LOX_OUTPUT_H)
+#define LOX_OUTPUT_H
+
+#include <fmt/format.h>
+
+#include <iterator>
+#include <string>
+#include <utility>
+
+namespace lox
+{
+/// Where this thread's output is being captured, or null when it goes straight to stdout
+auto captured_output() -> std::string*;
+
+/// While alive, everything this thread prints through lox::print is appended to buffer instead of
+/// written to stdout, so that scripts run concurrently don't interleave their output
+struct OutputCapture
+{
+  explicit OutputCapture(std::string* buffer);
+  OutputCapture(OutputCapture const&) = delete;
+  auto operator=(OutputCapture const&) -> OutputCapture& = delete;
+  ~OutputCapture();
+
+  std::string* m_previous;
+};
+
+/// Print to stdout, or to this thread's capture if it has one
+template <typename... Args>
+auto print(fmt::format_string<Args...> format, Args&&... args) -> void
+{
+  if (auto* const buffer = captured_output())
+  {
+    fmt::format_to(std::back_inserter(*buffer), format, std::forward<Args>(args)...);
+  }
+  else fmt::print(format, std::forward<Args>(args)...);
+}
+}  // namespace lox
+
+#endif  // LOX_OUTPUT_H
@@ -0,0 +1,52 @@
+#pragma once
+#if !defined(LOX_SIMD_H)
+#define LOX_SIMD_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace lox
+{
+namespace simd
+{
+/// Instruction sets which the scanning kernels are implemented for
+enum class ISA : uint8_t
+{
+  SCALAR,
+  SSE2,
+  AVX2,
+};
+
+/// The best instruction set supported by this machine
+auto supported_isa() -> ISA;
+
+/// The instruction set the kernels currently dispatch to, defaults to supported_isa()
+auto active_isa() -> ISA;
+
+/// Force the kernels to use an instruction set, clamped to what this machine supports. Returns the
+/// instruction set which was actually selected. Safe to call while other threads are scanning, which
+/// switch over on their next call.
+auto set_isa(ISA isa) -> ISA;
+
+/// Where a kernel stopped, and how many newlines it stepped over on the way
+struct Scanned
+{
+  char const* position;
+  std::size_t newlines;
+};
+
+/// Skip characters matched by \s, stopping at the first other character or last
+auto skip_whitespace(char const* first, char const* last) -> Scanned;
+
+/// Find the first occurrence of c, or last if there is none
+auto find(char const* first, char const* last, char c) -> Scanned;
+
+/// Find the first "*/" which closes a block comment, or last if there is none
+auto find_comment_end(char const* first, char const* last) -> Scanned;
+
+/// Count the newlines in [first, last)
+auto count_newlines(char const* first, char const* last) -> std::size_t;
+}  // namespace simd
+}  // namespace lox
+
+#endif  // LOX_SIMD_H
@@ -0,0 +1,41 @@
+#pragma once
+#if !defined(LOX_SOURCE_H)
+#define LOX_SOURCE_H
+
+#include <filesystem>
+#include <string>
+#include <string_view>
+
+#include "lox/error.hpp"
+
+namespace lox
+{
+/// Owns the text of a script. Regular files are memory mapped read-only so that token lexemes
+/// refer straight into the mapping, anything which can't be mapped (pipes, devices, files reporting a
+/// size of zero) is read into a buffer instead.
+struct Source
+{
+  Source() = default;
+  Source(Source&& other) noexcept;
+  auto operator=(Source&& other) noexcept -> Source&;
+  Source(Source const&) = delete;
+  auto operator=(Source const&) -> Source& = delete;
+  ~Source();
+
+  auto view() const -> std::string_view
+  {
+    return m_mapping ? std::string_view{m_mapping, m_size} : std::string_view{m_buffer};
+  }
+
+  // Non-null when the source is memory mapped
+  char const* m_mapping = nullptr;
+  std::size_t m_size = 0;
+  // Fallback storage for sources which could not be mapped
+  std::string m_buffer;
+};
+
+/// Open the script at path, mapping it when possible
+auto load_source(std::filesystem::path const& path) -> result<Source>;
+}  // namespace lox
+
+#endif  // LOX_SOURCE_H
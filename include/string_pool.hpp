@@ -0,0 +1,39 @@
+#pragma once
+#if !defined(LOX_STRING_POOL_H)
+#define LOX_STRING_POOL_H
+
+#include <cstdint>
+#include <memory>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace lox
+{
+/// Identifies a string interned in a StringPool
+using Symbol = std::uint32_t;
+
+/// Keeps a single copy of every distinct string interned, identified by a dense Symbol. Strings are
+/// packed into large blocks so interning rarely allocates, and remain valid for the pool's lifetime.
+struct StringPool
+{
+  /// Get the symbol for str, copying it into the pool if it hasn't been seen before
+  auto intern(std::string_view str) -> Symbol;
+
+  auto operator[](Symbol symbol) const -> std::string_view { return m_strings[symbol]; }
+
+  auto size() const -> std::size_t { return m_strings.size(); }
+
+  static constexpr std::size_t block_size = 1 << 16;
+
+  std::vector<std::unique_ptr<char[]>> m_blocks;
+  // Unused space at the end of the newest block
+  char* m_next = nullptr;
+  std::size_t m_remaining = 0;
+  // Interned strings, indexed by symbol
+  std::vector<std::string_view> m_strings;
+  std::unordered_map<std::string_view, Symbol> m_lookup;
+};
+}  // namespace lox
+
+#endif  // LOX_STRING_POOL_H
@@ -0,0 +1,67 @@
+#pragma once
+#if !defined(LOX_THREAD_POOL_H)
+#define LOX_THREAD_POOL_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+namespace lox
+{
+/// Runs tasks on a fixed set of worker threads. Each worker has its own queue which it takes the
+/// oldest task from, and once that is empty steals the newest task from another worker's queue, so
+/// workers only contend when one runs dry.
+struct ThreadPool
+{
+  using Task = std::function<void()>;
+
+  explicit ThreadPool(std::size_t threads);
+  ThreadPool(ThreadPool const&) = delete;
+  auto operator=(ThreadPool const&) -> ThreadPool& = delete;
+  /// Finishes every submitted task before joining the workers
+  ~ThreadPool();
+
+  /// Queue task on the calling worker's own queue, or spread over the workers when submitted from
+  /// outside the pool
+  auto submit(Task task) -> void;
+
+  /// Block until every task submitted so far has finished
+  auto wait() -> void;
+
+  auto size() const -> std::size_t { return m_workers.size(); }
+
+private:
+  struct Queue
+  {
+    std::mutex m_mutex;
+    std::deque<Task> m_tasks;
+  };
+
+  auto work(std::size_t index) -> void;
+  // Own queue first, then every other queue in turn
+  auto take(std::size_t index) -> std::optional<Task>;
+
+  // Mutexes can't move, so queues are held by pointer
+  std::vector<std::unique_ptr<Queue>> m_queues;
+  std::vector<std::thread> m_workers;
+  // Guards the counts below, which workers sleep on. Taken while holding a queue's lock, never the
+  // other way around.
+  std::mutex m_mutex;
+  std::condition_variable m_queued_changed;
+  std::condition_variable m_idle;
+  // Tasks in a queue, and tasks submitted but not yet finished
+  std::size_t m_queued = 0;
+  std::size_t m_pending = 0;
+  // Queue the next task from outside the pool goes to
+  std::size_t m_next = 0;
+  bool m_stopping = false;
+};
+}  // namespace lox
+
+#endif  // LOX_THREAD_POOL_H
@@ -3,11 +3,13 @@
 #define LOX_TOKEN_H
 
 #include <cstdint>
+#include <string>
 #include <string_view>
-#include <variant>
+#include <type_traits>
 #include <vector>
 
 #include "lox/error.hpp"
+#include "lox/string_pool.hpp"
 
 namespace lox
 {
@@ -35,11 +37,16 @@ enum class TOKEN_TYPE : uint8_t
 
 struct Token
 {
-  using literal = std::variant<std::monostate, std::string, float, bool>;
   TOKEN_TYPE type;
   std::string_view lexeme;
-  std::size_t line;
-  literal literal_value{std::monostate{}};
+  std::uint32_t line;
+  // Interned text of IDENTIFIER tokens, and STRING tokens without their quotes
+  Symbol symbol = 0;
+  // Value of NUMBER tokens
+  float number = 0.f;
 };
+// Tokens are copied freely by the parser, so must stay cheap to copy
+static_assert(std::is_trivially_copyable_v<Token>);
+static_assert(sizeof(Token) <= 64);
 }  // namespace lox
 #endif  // LOX_TOKEN_H
@@ -0,0 +1,83 @@
+#pragma once
+#if !defined(LOX_TOKEN_STREAM_H)
+#define LOX_TOKEN_STREAM_H
+
+#include <chrono>
+#include <deque>
+#include <optional>
+#include <string_view>
+
+#include "lox/allocation.hpp"
+#include "lox/error.hpp"
+#include "lox/lex.hpp"
+#include "lox/string_pool.hpp"
+#include "lox/token.hpp"
+
+namespace lox
+{
+/// Lexes tokens from a source on demand, dropping comments as they are produced. Tokens are only
+/// buffered while the parser may still backtrack over them, see release.
+struct TokenStream
+{
+  using clock = std::chrono::steady_clock;
+
+  TokenStream(std::string_view source, StringPool* pool, LEX_BACKEND backend = LEX_BACKEND::SCANNER);
+
+  /// Get the token at an absolute position in the stream, lexing up to it if required. Returns
+  /// nullptr if the source is exhausted before reaching position, or a lexical error occurred.
+  auto at(std::size_t position) -> Token const*;
+
+  /// Discard buffered tokens which precede position. The token directly before position is kept so
+  /// that errors may still report its line.
+  auto release(std::size_t position) -> void;
+
+  /// The first lexical error encountered, if any
+  auto error() const -> std::optional<Error> const& { return m_error; }
+
+  /// Lex the next token from the source, including comments, timing it when measured
+  auto lex() -> result<Token>;
+
+  std::string_view m_source;
+  std::uint32_t m_line = 1;
+  // Receives the text of every string and identifier token
+  StringPool* m_pool;
+  LEX_BACKEND m_backend;
+  std::deque<Token> m_buffer;
+  // Absolute position of the first buffered token
+  std::size_t m_offset = 0;
+  std::optional<Error> m_error;
+
+  // Tokens handed to the parser, and the most held in the buffer at once
+  std::size_t m_tokens = 0;
+  std::size_t m_peak_buffered = 0;
+  // Time spent and allocations made lexing, which is interleaved with parsing, only kept when measured
+  bool m_measured = false;
+  clock::time_point m_lex_start{};
+  clock::duration m_lex_time{};
+  AllocationStats m_lex_allocated;
+};
+
+/// A position in a TokenStream. Mirrors the subset of the span interface that the parser relies on,
+/// so rules can look ahead and backtrack by copying cursors around.
+struct TokenCursor
+{
+  auto empty() const -> bool { return m_stream->at(m_position) == nullptr; }
+
+  auto operator[](std::size_t i) const -> Token const& { return *m_stream->at(m_position + i); }
+
+  auto subspan(std::size_t count) const -> TokenCursor { return {m_stream, m_position + count}; }
+
+  /// Look up the interned text of a token
+  auto text(Symbol symbol) const -> std::string_view { return (*m_stream->m_pool)[symbol]; }
+
+  /// The token preceding this position, for reporting errors. At the start of the stream, or once the
+  /// preceding token is released, this is the current token, or an empty END token on the lexer's
+  /// line if there is none.
+  auto previous() const -> Token;
+
+  TokenStream* m_stream;
+  std::size_t m_position;
+};
+}  // namespace lox
+
+#endif  // LOX_TOKEN_STREAM_H
@@ -0,0 +1,129 @@
+#pragma once
+#if !defined(LOX_TRACE_H)
+#define LOX_TRACE_H
+
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <string_view>
+#include <vector>
+
+#include "lox/error.hpp"
+
+namespace lox
+{
+struct Program;
+struct TokenStream;
+
+/// Records timed spans and counters, to be written as Chrome trace event JSON which
+/// chrome://tracing and Perfetto can display. Names must outlive the tracer, string literals are
+/// expected.
+struct Tracer
+{
+  using clock = std::chrono::steady_clock;
+  static constexpr bool enabled = true;
+
+  // Records a complete event covering its lifetime
+  struct Span
+  {
+    Span(Tracer* tracer, std::string_view name, std::uint32_t line)
+      : m_tracer(tracer), m_name(name), m_line(line), m_start(clock::now())
+    {
+    }
+    Span(Span const&) = delete;
+    auto operator=(Span const&) -> Span& = delete;
+    ~Span() { m_tracer->m_events.push_back({'X', m_name, m_line, m_start, clock::now() - m_start, 0}); }
+
+    Tracer* m_tracer;
+    std::string_view m_name;
+    std::uint32_t m_line;
+    clock::time_point m_start;
+  };
+
+  /// Time from now until the returned span is destroyed, optionally attributed to a source line
+  auto span(std::string_view name, std::uint32_t line = 0) -> Span { return Span{this, name, line}; }
+
+  /// Record the value of a counter as of now
+  auto counter(std::string_view name, double value) -> void
+  {
+    m_events.push_back({'C', name, 0, clock::now(), {}, value});
+  }
+
+  /// Record the size of a program once it is ready to run
+  auto program(Program const& program) -> void;
+
+  /// Record the lexing done by tokens while it was parsed, as a span nested in the parse
+  auto lexed(TokenStream const& tokens) -> void;
+
+  /// Write every event recorded so far
+  auto write(std::filesystem::path const& path) const -> result<void>;
+
+  struct Event
+  {
+    // Trace event phase, 'X' for a complete span or 'C' for a counter
+    char m_phase;
+    std::string_view m_name;
+    std::uint32_t m_line;
+    clock::time_point m_start;
+    clock::duration m_duration;
+    double m_value;
+  };
+
+  // Timestamps are relative to the tracer's creation
+  clock::time_point m_origin = clock::now();
+  std::vector<Event> m_events;
+};
+
+/// Stands in for Tracer when tracing is off, every call compiles away
+struct NullTracer
+{
+  static constexpr bool enabled = false;
+
+  struct Span
+  {
+  };
+
+  auto span(std::string_view, std::uint32_t = 0) -> Span { return {}; }
+  auto counter(std::string_view, double) -> void {}
+  auto program(Program const&) -> void {}
+  auto lexed(TokenStream const&) -> void {}
+};
+
+/// Forwards to two tracers at once
+template <typename First, typename Second>
+struct TracerPair
+{
+  static constexpr bool enabled = First::enabled || Second::enabled;
+
+  struct Span
+  {
+    typename First::Span m_first;
+    typename Second::Span m_second;
+  };
+
+  auto span(std::string_view name, std::uint32_t line = 0) -> Span
+  {
+    return Span{m_first->span(name, line), m_second->span(name, line)};
+  }
+  auto counter(std::string_view name, double value) -> void
+  {
+    m_first->counter(name, value);
+    m_second->counter(name, value);
+  }
+  auto program(Program const& program) -> void
+  {
+    m_first->program(program);
+    m_second->program(program);
+  }
+  auto lexed(TokenStream const& tokens) -> void
+  {
+    m_first->lexed(tokens);
+    m_second->lexed(tokens);
+  }
+
+  First* m_first;
+  Second* m_second;
+};
+}  // namespace lox
+
+#endif  // LOX_TRACE_H
@@ -0,0 +1,159 @@
+#pragma once
+#if !defined(LOX_VALUE_H)
+#define LOX_VALUE_H
+
+#include <fmt/format.h>
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <variant>
+
+namespace lox
+{
+/// Type of a runtime Value
+enum class VALUE_TYPE : uint8_t
+{
+  NIL,
+  STRING,
+  NUMBER,
+  BOOL,
+};
+
+/// Immutable heap string shared between values. Concatenations are stored as a rope, referencing
+/// both halves, and are only copied into a flat string the first time their contents are needed.
+struct StringObject
+{
+  std::uint32_t m_references;
+  std::size_t m_length;
+  // The contents, once flat
+  std::string m_string;
+  // Both halves of a concatenation which hasn't been flattened yet, otherwise null
+  StringObject* m_left = nullptr;
+  StringObject* m_right = nullptr;
+};
+
+/// A runtime value packed into 8 bytes. Numbers are stored as doubles, every other type is encoded
+/// in the payload of a quiet NaN, with strings held as a pointer to a reference counted
+/// StringObject. Numbers keep single precision semantics.
+struct Value
+{
+  // Set on every boxed, non-number value
+  static constexpr std::uint64_t quiet_nan = 0x7ffc000000000000;
+  // Distinguishes strings from the other boxed values
+  static constexpr std::uint64_t string_tag = 0x8000000000000000;
+  static constexpr std::uint64_t nil_bits = quiet_nan | 1;
+  static constexpr std::uint64_t false_bits = quiet_nan | 2;
+  static constexpr std::uint64_t true_bits = quiet_nan | 3;
+  static constexpr std::uint64_t pointer_mask = 0x0000ffffffffffff;
+
+  Value() = default;
+  Value(std::monostate) {}
+  Value(bool v) : m_bits(v ? true_bits : false_bits) {}
+  Value(float v)
+  {
+    // Arithmetic may produce a NaN whose payload collides with a boxed value
+    double const d = std::isnan(v) ? std::numeric_limits<double>::quiet_NaN() : v;
+    std::memcpy(&m_bits, &d, sizeof(d));
+  }
+  Value(std::string_view v);
+  Value(std::string const& v) : Value(std::string_view{v}) {}
+  Value(char const* v) : Value(std::string_view{v}) {}
+  Value(std::string&& v);
+
+  Value(Value const& other) : m_bits(other.m_bits)
+  {
+    if (is_string()) ++as_object()->m_references;
+  }
+  Value(Value&& other) noexcept : m_bits(other.m_bits) { other.m_bits = nil_bits; }
+  auto operator=(Value const& other) -> Value&
+  {
+    Value copy{other};
+    std::swap(m_bits, copy.m_bits);
+    return *this;
+  }
+  auto operator=(Value&& other) noexcept -> Value&
+  {
+    std::swap(m_bits, other.m_bits);
+    return *this;
+  }
+  ~Value()
+  {
+    if (is_string()) release();
+  }
+
+  auto is_number() const -> bool { return (m_bits & quiet_nan) != quiet_nan; }
+  auto is_string() const -> bool { return (m_bits & (quiet_nan | string_tag)) == (quiet_nan | string_tag); }
+  auto is_bool() const -> bool { return (m_bits | 1) == true_bits; }
+  auto is_nil() const -> bool { return m_bits == nil_bits; }
+
+  auto type() const -> VALUE_TYPE
+  {
+    if (is_number()) return VALUE_TYPE::NUMBER;
+    if (is_string()) return VALUE_TYPE::STRING;
+    return is_nil() ? VALUE_TYPE::NIL : VALUE_TYPE::BOOL;
+  }
+
+  auto as_number() const -> float
+  {
+    double d;
+    std::memcpy(&d, &m_bits, sizeof(d));
+    return static_cast<float>(d);
+  }
+  auto as_bool() const -> bool { return m_bits == true_bits; }
+  /// Contents of a string, flattening it first if it's a concatenation
+  auto as_string() const -> std::string const&
+  {
+    auto const object = as_object();
+    if (object->m_left) flatten(object);
+    return object->m_string;
+  }
+  /// Length of a string, without flattening it
+  auto string_length() const -> std::size_t { return as_object()->m_length; }
+
+  std::uint64_t m_bits = nil_bits;
+
+private:
+  auto as_object() const -> StringObject*
+  {
+    return reinterpret_cast<StringObject*>(static_cast<std::uintptr_t>(m_bits & pointer_mask));
+  }
+  auto release() -> void;
+  static auto flatten(StringObject* object) -> void;
+
+  friend auto concatenate(Value const& lhs, Value const& rhs) -> Value;
+};
+static_assert(sizeof(Value) == 8);
+
+/// Values are equal when they have the same type and equal contents
+auto operator==(Value const& lhs, Value const& rhs) -> bool;
+auto operator!=(Value const& lhs, Value const& rhs) -> bool;
+/// Values of different types are ordered by type
+auto operator<(Value const& lhs, Value const& rhs) -> bool;
+auto operator<=(Value const& lhs, Value const& rhs) -> bool;
+auto operator>(Value const& lhs, Value const& rhs) -> bool;
+auto operator>=(Value const& lhs, Value const& rhs) -> bool;
+
+/// Convert a value to a string for concatenation, strings are unquoted
+auto to_string(Value const& value) -> std::string;
+
+/// Join two strings, sharing rather than copying their contents unless they are short
+auto concatenate(Value const& lhs, Value const& rhs) -> Value;
+}  // namespace lox
+
+template <>
+struct fmt::formatter<lox::Value>
+{
+  constexpr auto parse(fmt::format_parse_context& ctx) { return ctx.begin(); }
+
+  template <typename FormatContext>
+  auto format(lox::Value const& value, FormatContext& ctx)
+  {
+    if (value.is_string()) return format_to(ctx.out(), "'{}'", value.as_string());
+    return format_to(ctx.out(), "{}", lox::to_string(value));
+  }
+};
+#endif  // LOX_VALUE_H
@@ -0,0 +1,96 @@
+#pragma once
+#if !defined(LOX_VM_CHUNK_H)
+#define LOX_VM_CHUNK_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "lox/environment.hpp"
+#include "lox/token.hpp"
+#include "lox/value.hpp"
+
+namespace lox
+{
+/// Instructions understood by the VM. Most operate on an accumulator which mirrors the tree
+/// interpreter's result, with a stack holding pending left hand operands. Operands follow the op
+/// code as 32-bit little endian integers.
+enum class OP_CODE : uint8_t
+{
+  // accumulator = constants[operand]
+  CONSTANT,
+  // accumulator = nil
+  NIL,
+  // accumulator = the variable accessed by accesses[operand]
+  READ,
+  // Define the variable at slot operand of the innermost scope from the accumulator
+  DEFINE,
+  // Assign the variable accessed by accesses[operand] from the accumulator
+  ASSIGN,
+  // Print the accumulator, then set it to nil
+  PRINT,
+  // Push the accumulator onto the stack
+  PUSH,
+  // accumulator = pop() op accumulator
+  ADD,
+  SUBTRACT,
+  MULTIPLY,
+  DIVIDE,
+  GREATER,
+  GREATER_EQUAL,
+  LESS,
+  LESS_EQUAL,
+  NOT_EQUAL,
+  EQUAL,
+  // accumulator = op accumulator
+  NEGATE,
+  NOT,
+  // Jump to the absolute offset operand, conditionally on the accumulator being falsey
+  JUMP,
+  JUMP_IF_FALSE,
+  // Enter a scope declaring operand variables
+  PUSH_SCOPE,
+  POP_SCOPE,
+  // End of a top level declaration
+  RETURN,
+};
+
+/// Instructions in [m_begin, m_end) belong to a single declaration in a block. An error raised by
+/// them is swallowed, resuming at m_end with m_depth values on the stack.
+struct Handler
+{
+  std::uint32_t m_begin;
+  std::uint32_t m_end;
+  std::uint32_t m_depth;
+};
+
+/// A resolved variable access, whose binding is m_count slots from m_first in the chunk's slots
+struct Access
+{
+  std::uint32_t m_name;
+  std::uint32_t m_first;
+  std::uint32_t m_count;
+};
+
+/// A compiled program
+struct Chunk
+{
+  auto binding(Access const& access) const -> Binding
+  {
+    return {m_slots.data() + access.m_first, static_cast<std::ptrdiff_t>(access.m_count)};
+  }
+
+  std::vector<std::uint8_t> m_code;
+  std::vector<Value> m_constants;
+  // Variable names, only needed to report undefined variables
+  std::vector<std::string> m_names;
+  std::vector<Access> m_accesses;
+  std::vector<Slot> m_slots;
+  // Ordered by m_begin, so that nested handlers follow their parent
+  std::vector<Handler> m_handlers;
+  // Entry point of each top level declaration
+  std::vector<std::uint32_t> m_roots;
+};
+}  // namespace lox
+
+#endif  // LOX_VM_CHUNK_H
@@ -0,0 +1,14 @@
+#pragma once
+#if !defined(LOX_VM_COMPILER_H)
+#define LOX_VM_COMPILER_H
+
+#include "lox/ast/parse.hpp"
+#include "lox/vm/chunk.hpp"
+
+namespace lox
+{
+/// Compile a parsed program to bytecode, with one entry point per top level declaration
+auto compile(Program const& program) -> Chunk;
+}  // namespace lox
+
+#endif  // LOX_VM_COMPILER_H
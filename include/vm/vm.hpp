@@ -0,0 +1,23 @@
+#pragma once
+#if !defined(LOX_VM_VM_H)
+#define LOX_VM_VM_H
+
+#include "lox/environment.hpp"
+#include "lox/vm/chunk.hpp"
+
+namespace lox
+{
+/// Executes compiled chunks, producing exactly the same output and errors as Interpreter
+struct VM
+{
+  /// Execute a top level declaration of chunk, leaving its value in result
+  auto run(Chunk const& chunk, std::size_t root) -> lox::result<void>;
+
+  Environment environment;
+  Value result;
+  // Left hand operands waiting on their right hand side
+  std::vector<Value> stack;
+};
+}  // namespace lox
+
+#endif  // LOX_VM_VM_H
@@ -1,18 +1,48 @@
 #include <fmt/format.h>
 
+#include <algorithm>
+#include <chrono>
 #include <cstdlib>
 #include <filesystem>
 #include <fstream>
-#include <gsl/span>
+#include <future>
 #include <iostream>
+#include <thread>
+#include <vector>
 #include <magic_enum/magic_enum.hpp>
 #include <structopt/app.hpp>
 
+#include "lox/allocation.hpp"
+#include "lox/ast/cache.hpp"
+#include "lox/ast/count.hpp"
 #include "lox/ast/expression.hpp"
 #include "lox/ast/interpreter.hpp"
+#include "lox/ast/optimize.hpp"
 #include "lox/ast/parse.hpp"
 #include "lox/ast/printer.hpp"
+#include "lox/ast/profiler.hpp"
+#include "lox/ast/resolve.hpp"
+#include "lox/closure/compiler.hpp"
 #include "lox/lex.hpp"
+#include "lox/memory_stats.hpp"
+#include "lox/output.hpp"
+#include "lox/source.hpp"
+#include "lox/thread_pool.hpp"
+#include "lox/token_stream.hpp"
+#include "lox/trace.hpp"
+#include "lox/vm/compiler.hpp"
+#include "lox/vm/vm.hpp"
+
+// How parsed programs are executed
+enum class ENGINE : uint8_t
+{
+  // Walk the syntax tree directly
+  TREE,
+  // Compile to bytecode for a virtual machine
+  VM,
+  // Compile the syntax tree to a tree of closures
+  CLOSURE,
+};
 
 
 struct Options
@@ -28,8 +58,56 @@ struct Options
 
   // Display the list of tokens which comprise the program
   std::optional<bool> immediate_result_dump = false;
+
+  // Lexer implementation to use, REGEX or SCANNER
+  std::optional<lox::LEX_BACKEND> lexer = lox::LEX_BACKEND::SCANNER;
+
+  // Execution engine to use, TREE, VM or CLOSURE
+  std::optional<ENGINE> engine = ENGINE::TREE;
+
+  // Fold constants and simplify the ast before executing it
+  std::optional<bool> optimize = false;
+
+  // Run on the tree interpreter, reporting the time spent in each kind of node and source line
+  std::optional<bool> profile = false;
+
+  // File to write the profile to as collapsed stacks, for flamegraph tools
+  std::optional<std::string> profile_stacks;
+
+  // File to write the time taken by each phase to, as Chrome trace event JSON
+  std::optional<std::string> trace;
+
+  // Report the allocations made by each phase and the size of the syntax tree and environment
+  std::optional<bool> mem_stats = false;
+
+  // Reuse the parse of an unchanged script, cached in a file next to it
+  std::optional<bool> cache = false;
+
+  // Directory to cache parsed scripts in, keyed by their contents, rather than next to each script
+  std::optional<std::string> cache_dir;
+
+  // Scripts to run concurrently rather than one script, @file reads a list of scripts from file
+  std::optional<std::vector<std::string>> batch;
+
+  // Scripts run at once in a batch, by default one per hardware thread
+  std::optional<std::size_t> jobs;
 };
-STRUCTOPT(Options, script, ast_dump, token_dump, immediate_result_dump);
+STRUCTOPT(Options,
+          script,
+          ast_dump,
+          token_dump,
+          immediate_result_dump,
+          lexer,
+          engine,
+          optimize,
+          profile,
+          profile_stacks,
+          trace,
+          mem_stats,
+          cache,
+          cache_dir,
+          batch,
+          jobs);
 
 
 struct DisplaySettings
@@ -39,68 +117,341 @@ struct DisplaySettings
   bool immediate_result = false;
 };
 
-auto run(std::string_view source, lox::Interpreter* interpreter, DisplaySettings const& display)
-  -> lox::result<void>
+struct RunSettings
 {
-  return lox::lex(source)
-    .map([=](auto&& tokens) {
-      if (display.token_dump)
-      {
-        for (auto const& token : tokens) fmt::print("{}\n", magic_enum::enum_name(token.type));
-      }
-      tokens.erase(
-        std::remove_if(tokens.begin(),
-                       tokens.end(),
-                       [](auto const& token) { return token.type == lox::TOKEN_TYPE::COMMENT; }),
-        tokens.end());
-      return std::move(tokens);
-    })
-    .and_then([](auto&& tokens) { return lox::parse(tokens); })
-    .map([=](auto const& parsed) {
+  lox::LEX_BACKEND lexer = lox::LEX_BACKEND::SCANNER;
+  ENGINE engine = ENGINE::TREE;
+  bool optimize = false;
+  bool profile = false;
+  // Where to write collapsed stacks when profiling, if anywhere
+  std::optional<std::string> profile_stacks;
+  // Where to write a trace of each phase, if anywhere
+  std::optional<std::string> trace;
+  bool mem_stats = false;
+  bool cache = false;
+  std::optional<std::string> cache_dir;
+};
+
+// Lines of source listed in a profile report
+constexpr std::size_t profiled_lines = 20;
+
+// Execution state which persists between runs, one per engine
+struct Session
+{
+  // Remembers the slots of globals, which live in the engine's environment
+  lox::Resolver resolver;
+  lox::Interpreter interpreter;
+  lox::BasicInterpreter<lox::Profiler> profiled;
+  lox::VM vm;
+  lox::ClosureInterpreter closures;
+  // Events from every run so far, only recorded when tracing
+  lox::Tracer tracer;
+  // Allocations of every run so far, only counted when asked for
+  lox::MemoryStats memory;
+
+  // Value left by the last declaration run with settings
+  auto result(RunSettings const& settings) const -> lox::Value const&
+  {
+    if (settings.profile) return profiled.result;
+    switch (settings.engine)
+    {
+    case ENGINE::VM: return vm.result;
+    case ENGINE::CLOSURE: return closures.result;
+    default: return interpreter.result;
+    }
+  }
+
+  // Variables of the engine used by settings
+  auto environment(RunSettings const& settings) const -> lox::Environment const&
+  {
+    if (settings.profile) return profiled.environment;
+    switch (settings.engine)
+    {
+    case ENGINE::VM: return vm.environment;
+    case ENGINE::CLOSURE: return closures.environment;
+    default: return interpreter.environment;
+    }
+  }
+};
+
+// Lex and parse source, timing each with tracer
+template <typename Tracer>
+auto parse(std::string_view source,
+           lox::StringPool* pool,
+           DisplaySettings const& display,
+           RunSettings const& settings,
+           Tracer* tracer) -> lox::parse_list_result
+{
+  if (display.token_dump)
+  {
+    // Lex the whole source up front so that trivia is also displayed
+    auto const lexed = lox::lex(source, pool, settings.lexer);
+    if (!lexed) return lox::error(lexed.error());
+    for (auto const& token : *lexed) lox::print("{}\n", magic_enum::enum_name(token.type));
+  }
+  // Tokens are lexed lazily as the parser consumes them, so lexing is measured by the stream
+  lox::TokenStream tokens{source, pool, settings.lexer};
+  tokens.m_measured = Tracer::enabled;
+  auto parsed = [&] {
+    [[maybe_unused]] auto const span = tracer->span("parse");
+    return lox::parse(tokens);
+  }();
+  tracer->lexed(tokens);
+  return parsed;
+}
+
+// Tracer times each phase, it is a NullTracer which compiles away unless a trace was asked for. The
+// parse of source is loaded from and saved to cache, when given.
+template <typename Tracer>
+auto run(std::string_view source,
+         Session* session,
+         DisplaySettings const& display,
+         RunSettings const& settings,
+         std::optional<std::filesystem::path> const& cache,
+         Tracer* tracer) -> lox::result<void>
+{
+  [[maybe_unused]] auto const span = tracer->span("run");
+  tracer->counter("source bytes", source.size());
+  // Owns the text of every string and identifier in this compilation
+  lox::StringPool pool;
+  auto program = [&]() -> lox::parse_list_result {
+    // Dumping tokens needs the lexer, even for an unchanged script
+    if (cache && !display.token_dump)
+    {
+      [[maybe_unused]] auto const span = tracer->span("load cache");
+      if (auto cached = lox::load_cached(*cache, source, &pool)) return std::move(*cached);
+    }
+    auto parsed = parse(source, &pool, display, settings, tracer);
+    if (parsed && cache)
+    {
+      // Caching is best effort, scripts in read only directories still run
+      [[maybe_unused]] auto const span = tracer->span("store cache");
+      lox::store_cached(*cache, *parsed, source);
+    }
+    return parsed;
+  }();
+  return std::move(program).map([=](auto&& parsed) {
+    if (settings.optimize)
+    {
+      [[maybe_unused]] auto const span = tracer->span("optimize");
+      lox::print("Optimizer removed {} nodes.\n", lox::optimize(&parsed));
+    }
+    {
+      [[maybe_unused]] auto const span = tracer->span("resolve");
+      session->resolver.resolve(&parsed);
+    }
+    tracer->program(parsed);
+    lox::Chunk chunk;
+    lox::ClosureProgram closures;
+    if (!settings.profile && settings.engine != ENGINE::TREE)
+    {
+      [[maybe_unused]] auto const span = tracer->span("compile");
+      if (settings.engine == ENGINE::VM) chunk = lox::compile(parsed);
+      if (settings.engine == ENGINE::CLOSURE) closures = lox::compile_closures(parsed);
+    }
+    for (std::size_t i = 0; i < parsed.m_expressions.size(); ++i)
+    {
+      auto const& expr = parsed.m_expressions[i];
       // Print the expression tree
-      for (auto const& expr : parsed)
+      if (display.ast_dump)
       {
-        if (display.ast_dump)
+        [[maybe_unused]] auto const span = tracer->span("print ast", expr->m_line);
+        lox::AstPrinter printer;
+        expr->accept(printer).map([&] { lox::print("{}\n", printer.m_ast); }).map_error(lox::report);
+      }
+      // Evaluate the expression
+      auto const execute = [&] {
+        [[maybe_unused]] auto const span = tracer->span("execute", expr->m_line);
+        if (settings.profile) return expr->accept(session->profiled);
+        switch (settings.engine)
         {
-          lox::AstPrinter printer;
-          expr->accept(printer).map([&] { fmt::print("{}\n", printer.m_ast); }).map_error(lox::report);
+        case ENGINE::VM: return session->vm.run(chunk, i);
+        case ENGINE::CLOSURE: return session->closures.run(closures, i);
+        default: return expr->accept(session->interpreter);
         }
-        // Evaluate the expression tree
-        expr->accept(*interpreter)
-          .map([&] {
-            if (display.immediate_result) fmt::print("{}\n", interpreter->result);
-          })
-          .map_error(lox::report);
-      }
-    });
+      };
+      execute()
+        .map([&] {
+          if (display.immediate_result) lox::print("{}\n", session->result(settings));
+        })
+        .map_error(lox::report);
+    }
+  });
 }
 
-auto run_file(std::filesystem::path file_path, DisplaySettings const& display) -> lox::result<void>
+// Run source with the tracers settings ask for, writing everything traced so far in the session
+auto run(std::string_view source,
+         Session* session,
+         DisplaySettings const& display,
+         RunSettings const& settings,
+         std::optional<std::filesystem::path> const& cache = std::nullopt) -> lox::result<void>
 {
-  std::ifstream file(file_path);
-  if (!file.is_open())
+  auto const ran = [&] {
+    if (settings.trace && settings.mem_stats)
+    {
+      lox::TracerPair<lox::Tracer, lox::MemoryStats> both{&session->tracer, &session->memory};
+      return run(source, session, display, settings, cache, &both);
+    }
+    if (settings.trace) return run(source, session, display, settings, cache, &session->tracer);
+    if (settings.mem_stats) return run(source, session, display, settings, cache, &session->memory);
+    lox::NullTracer tracer;
+    return run(source, session, display, settings, cache, &tracer);
+  }();
+  if (settings.trace) session->tracer.write(*settings.trace).map_error(lox::report);
+  return ran;
+}
+
+// Report on everything profiled and measured in the session so far
+auto report_statistics(Session const& session, RunSettings const& settings) -> void
+{
+  if (settings.profile)
   {
-    using namespace std::string_literals;
-    return lox::error("Failed to open file."s, 0ul);
+    auto const& profiler = session.profiled.hooks;
+    profiler.report(profiled_lines);
+    if (settings.profile_stacks) profiler.write_stacks(*settings.profile_stacks).map_error(lox::report);
   }
-  using source_iter = std::istreambuf_iterator<char>;
-  std::string const source{source_iter(file), source_iter{}};
-  lox::Interpreter interpreter;
-  return run(source, &interpreter, display);
+  if (settings.mem_stats) session.memory.report(session.environment(settings));
+}
+
+auto run_file(std::filesystem::path file_path,
+              DisplaySettings const& display,
+              RunSettings const& settings) -> lox::result<void>
+{
+  // Lexemes refer directly into the source, so it must outlive the run
+  auto const source = lox::load_source(file_path);
+  if (!source) return lox::error(source.error());
+  Session session;
+  session.profiled.hooks.m_collect_stacks = settings.profile_stacks.has_value();
+  std::optional<std::filesystem::path> cache;
+  if (settings.cache || settings.cache_dir) cache = lox::cache_path(file_path, settings.cache_dir, source->view());
+  auto ran = run(source->view(), &session, display, settings, cache);
+  report_statistics(session, settings);
+  return ran;
+}
+
+// Expand the entries of a batch into scripts, reading the list in any @file. Listed scripts are
+// relative to the list, which may leave blank lines and # comments.
+auto batch_scripts(std::vector<std::string> const& entries)
+  -> lox::result<std::vector<std::filesystem::path>>
+{
+  std::vector<std::filesystem::path> scripts;
+  for (auto const& entry : entries)
+  {
+    if (entry.empty() || entry.front() != '@')
+    {
+      scripts.emplace_back(entry);
+      continue;
+    }
+    std::filesystem::path const list = entry.substr(1);
+    std::ifstream file{list};
+    if (!file) return lox::error(fmt::format("Failed to open the script list '{}'.", list.string()), ~0u);
+    std::string line;
+    while (std::getline(file, line))
+    {
+      if (line.empty() || line.front() == '#') continue;
+      scripts.push_back(list.parent_path() / line);
+    }
+  }
+  return scripts;
 }
 
-auto run_prompt(DisplaySettings const& display) -> lox::result<void>
+// How one script in a batch went
+struct ScriptRun
+{
+  // Everything the script printed, including errors
+  std::string m_output;
+  // Whether it could be loaded and parsed
+  lox::result<void> m_status;
+  std::chrono::steady_clock::duration m_time{};
+};
+
+// Run each script on a thread pool, with a session of its own, as if each were run by its own
+// process. Output is captured per script and printed in order as soon as every earlier script has
+// finished, followed by a summary of how each script went.
+auto run_batch(std::vector<std::filesystem::path> const& scripts,
+               std::size_t jobs,
+               DisplaySettings const& display,
+               RunSettings const& settings) -> lox::result<void>
+{
+  if (settings.trace || settings.profile_stacks)
+  {
+    return lox::error(std::string{"--trace and --profile_stacks write one file, so can't be used with --batch."},
+                      ~0u);
+  }
+  using clock = std::chrono::steady_clock;
+  auto const start = clock::now();
+  std::vector<std::promise<ScriptRun>> promised(scripts.size());
+  std::vector<std::future<ScriptRun>> runs;
+  runs.reserve(scripts.size());
+  for (auto& promise : promised) runs.push_back(promise.get_future());
+
+  // Destroyed first, so every task has finished with the promises before they go
+  lox::ThreadPool pool{jobs};
+  for (std::size_t i = 0; i < scripts.size(); ++i)
+  {
+    pool.submit([&, i] {
+      ScriptRun run;
+      auto const started = clock::now();
+      {
+        lox::OutputCapture const capture{&run.m_output};
+        run.m_status = run_file(scripts[i], display, settings);
+        run.m_status.map_error(lox::report);
+      }
+      run.m_time = clock::now() - started;
+      promised[i].set_value(std::move(run));
+    });
+  }
+
+  std::vector<ScriptRun> finished;
+  finished.reserve(scripts.size());
+  for (std::size_t i = 0; i < scripts.size(); ++i)
+  {
+    auto& run = finished.emplace_back(runs[i].get());
+    fmt::print("Running lox file: {}\n{}", scripts[i].string(), run.m_output);
+    // Summaries of thousands of scripts shouldn't hold on to all of their output
+    std::string{}.swap(run.m_output);
+  }
+
+  auto const milliseconds = [](clock::duration time) {
+    return std::chrono::duration<double, std::milli>(time).count();
+  };
+  auto const failed = std::count_if(finished.begin(), finished.end(), [](auto const& run) {
+    return !run.m_status.has_value();
+  });
+  fmt::print("Batch: {} scripts, {} failed, in {:.3f} ms on {} threads\n",
+             scripts.size(),
+             failed,
+             milliseconds(clock::now() - start),
+             pool.size());
+  for (std::size_t i = 0; i < scripts.size(); ++i)
+  {
+    auto const& run = finished[i];
+    fmt::print("  {:<8} {:>10.3f} ms  {}",
+               run.m_status ? "ok" : "failed",
+               milliseconds(run.m_time),
+               scripts[i].string());
+    if (run.m_status) fmt::print("\n");
+    else fmt::print(": {}\n", run.m_status.error().describe());
+  }
+  if (failed) return lox::error(fmt::format("{} of {} scripts failed.", failed, scripts.size()), ~0u);
+  return lox::ok();
+}
+
+auto run_prompt(DisplaySettings const& display, RunSettings const& settings) -> lox::result<void>
 {
   std::string line;
   // Outside the loop for persistent variables
-  lox::Interpreter interpreter;
+  Session session;
+  session.profiled.hooks.m_collect_stacks = settings.profile_stacks.has_value();
   // Exit loop with CTRL + C
   while (true)
   {
     fmt::print(">> ");
     if (std::getline(std::cin, line) && !line.empty())
     {
-      run(line, &interpreter, display).map_error(lox::report);
+      run(line, &session, display, settings).map_error(lox::report);
+      // The repl only ends when killed, so statistics so far are reported after every line
+      report_statistics(session, settings);
     }
   }
   return lox::ok();
@@ -114,16 +465,35 @@ auto main(int argc, char* argv[]) -> int
     DisplaySettings const display{opts.ast_dump.value_or(false),
                                   opts.token_dump.value_or(false),
                                   opts.immediate_result_dump.value_or(false)};
-    if (opts.script)
+    RunSettings const settings{opts.lexer.value_or(lox::LEX_BACKEND::SCANNER),
+                               opts.engine.value_or(ENGINE::TREE),
+                               opts.optimize.value_or(false),
+                               opts.profile.value_or(false) || opts.profile_stacks.has_value(),
+                               opts.profile_stacks,
+                               opts.trace,
+                               opts.mem_stats.value_or(false),
+                               opts.cache.value_or(false),
+                               opts.cache_dir};
+    if (settings.mem_stats) lox::set_counting_allocations(true);
+    if (opts.batch)
+    {
+      auto const jobs = opts.jobs.value_or(std::thread::hardware_concurrency());
+      // Report the error and the end the process, after every script has run
+      batch_scripts(*opts.batch)
+        .and_then([&](auto const& scripts) { return run_batch(scripts, jobs, display, settings); })
+        .map_error(lox::report)
+        .map_error([](auto&&) { std::exit(65); });
+    }
+    else if (opts.script)
     {
       fmt::print("Running lox file: {}\n", *opts.script);
       // Report the error and the end the process
-      run_file(*opts.script, display).map_error(lox::report).map_error([](auto&&) { std::exit(65); });
+      run_file(*opts.script, display, settings).map_error(lox::report).map_error([](auto&&) { std::exit(65); });
     }
     else
     {
       fmt::print("Running lox repl\n");
-      run_prompt(display);
+      run_prompt(display, settings);
     }
   }
   catch (structopt::exception& e)
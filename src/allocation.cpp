@@ -0,0 +1,35 @@
+#include "lox/allocation.hpp"
+
+#include <sys/resource.h>
+
+#include <atomic>
+
+namespace
+{
+// Plain data, so that it needs no construction and is safe to use from any allocation
+thread_local lox::AllocationStats counted;
+// Constant initialised, so allocations made before main() read it safely
+std::atomic<bool> counting{false};
+}  // namespace
+
+namespace lox
+{
+auto allocations() -> AllocationStats { return counted; }
+
+auto set_counting_allocations(bool enabled) -> void { counting.store(enabled, std::memory_order_relaxed); }
+
+auto count_allocation(std::size_t size) noexcept -> void
+{
+  if (!counting.load(std::memory_order_relaxed)) return;
+  ++counted.m_count;
+  counted.m_bytes += size;
+}
+
+auto peak_resident_bytes() -> std::size_t
+{
+  rusage usage{};
+  if (::getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+  // Linux reports kilobytes
+  return static_cast<std::size_t>(usage.ru_maxrss) * 1024;
+}
+}  // namespace lox
@@ -0,0 +1,31 @@
+#include "lox/arena.hpp"
+
+#include <algorithm>
+#include <cstdint>
+
+namespace lox
+{
+Arena::~Arena()
+{
+  for (auto d = m_destructors.rbegin(); d != m_destructors.rend(); ++d) d->m_destroy(d->m_object);
+}
+
+auto Arena::allocate(std::size_t size, std::size_t align) -> void*
+{
+  auto padding = (align - reinterpret_cast<std::uintptr_t>(m_next) % align) % align;
+  if (size + padding > m_remaining)
+  {
+    // Oversized requests get a block of their own
+    auto const block = std::max(block_size, size + align);
+    m_blocks.emplace_back(new std::byte[block]);
+    m_reserved += block;
+    m_next = m_blocks.back().get();
+    m_remaining = block;
+    padding = (align - reinterpret_cast<std::uintptr_t>(m_next) % align) % align;
+  }
+  auto const object = m_next + padding;
+  m_next += padding + size;
+  m_remaining -= padding + size;
+  return object;
+}
+}  // namespace lox
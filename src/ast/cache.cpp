@@ -0,0 +1,458 @@
+#include "lox/ast/cache.hpp"
+
+#include <unistd.h>
+
+#include <fmt/format.h>
+
+#include <atomic>
+#include <cstring>
+#include <fstream>
+#include <system_error>
+#include <unordered_map>
+#include <vector>
+
+#include <magic_enum/magic_enum.hpp>
+
+#include "lox/source.hpp"
+
+// A cache file is a header, then a table of every name and string literal, then each declaration's
+// nodes in pre-order. Every node starts with its kind and line, followed by its own operands and then
+// its children. Values are stored in native byte order, the cache is never shared between machines.
+namespace lox
+{
+namespace
+{
+constexpr std::uint32_t magic = 0x43584f4c;  // "LOXC"
+
+// Numbers the temporary files of this process, as scripts in a batch may store the same cache at once
+std::atomic<std::uint32_t> stores{0};
+
+struct Header
+{
+  std::uint32_t m_magic;
+  std::uint32_t m_version;
+  std::uint64_t m_hash;
+  std::uint64_t m_size;
+  std::uint32_t m_strings;
+  std::uint32_t m_roots;
+};
+
+enum class LITERAL : uint8_t
+{
+  NIL,
+  BOOL,
+  NUMBER,
+  STRING,
+};
+
+struct Writer final : public AstVisitor
+{
+  virtual auto visit(Definition const& expr) -> result<void> override
+  {
+    node(NODE_KIND::DEFINITION, expr);
+    name(expr.m_name);
+    return expr.m_value->accept(*this);
+  }
+  virtual auto visit(Read const& expr) -> result<void> override
+  {
+    node(NODE_KIND::READ, expr);
+    name(expr.m_name);
+    return lox::ok();
+  }
+  virtual auto visit(Statement const& expr) -> result<void> override
+  {
+    node(NODE_KIND::STATEMENT, expr);
+    return expr.m_expression->accept(*this);
+  }
+  virtual auto visit(Block const& expr) -> result<void> override
+  {
+    node(NODE_KIND::BLOCK, expr);
+    write(static_cast<std::uint32_t>(expr.m_expressions.size()));
+    for (auto const& e : expr.m_expressions) e->accept(*this);
+    return lox::ok();
+  }
+  virtual auto visit(Print const& expr) -> result<void> override
+  {
+    node(NODE_KIND::PRINT, expr);
+    return expr.m_value->accept(*this);
+  }
+  virtual auto visit(Assign const& expr) -> result<void> override
+  {
+    node(NODE_KIND::ASSIGN, expr);
+    name(expr.m_name);
+    return expr.m_value->accept(*this);
+  }
+  virtual auto visit(Ternary const& expr) -> result<void> override
+  {
+    node(NODE_KIND::TERNARY, expr);
+    expr.m_cond->accept(*this);
+    expr.m_left->accept(*this);
+    return expr.m_right->accept(*this);
+  }
+  virtual auto visit(Binary const& expr) -> result<void> override
+  {
+    node(NODE_KIND::BINARY, expr);
+    write(expr.m_op);
+    expr.m_left->accept(*this);
+    return expr.m_right->accept(*this);
+  }
+  virtual auto visit(Group const& expr) -> result<void> override
+  {
+    node(NODE_KIND::GROUP, expr);
+    return expr.m_expression->accept(*this);
+  }
+  virtual auto visit(Literal const& expr) -> result<void> override
+  {
+    node(NODE_KIND::LITERAL, expr);
+    auto const& value = expr.m_literal;
+    if (value.is_number())
+    {
+      write(LITERAL::NUMBER);
+      write(value.as_number());
+    }
+    else if (value.is_string())
+    {
+      write(LITERAL::STRING);
+      write(string(value.as_string()));
+    }
+    else if (value.is_bool())
+    {
+      write(LITERAL::BOOL);
+      write(static_cast<std::uint8_t>(value.as_bool()));
+    }
+    else
+    {
+      write(LITERAL::NIL);
+    }
+    return lox::ok();
+  }
+  virtual auto visit(Unary const& expr) -> result<void> override
+  {
+    node(NODE_KIND::UNARY, expr);
+    write(expr.m_op);
+    return expr.m_expression->accept(*this);
+  }
+
+  template <typename T>
+  auto write(T const& value) -> void
+  {
+    m_nodes.append(reinterpret_cast<char const*>(&value), sizeof(value));
+  }
+
+  auto node(NODE_KIND kind, Expression const& expr) -> void
+  {
+    write(kind);
+    write(expr.m_line);
+  }
+
+  auto name(Token const& token) -> void { write(string(token.lexeme)); }
+
+  // Index of str in the string table, adding it if it's new
+  auto string(std::string_view str) -> std::uint32_t
+  {
+    auto const [it, added] = m_indices.try_emplace(std::string{str}, m_strings.size());
+    if (added) m_strings.push_back(it->first);
+    return it->second;
+  }
+
+  std::string m_nodes;
+  std::unordered_map<std::string, std::uint32_t> m_indices;
+  // Views of the keys in m_indices, which are stable, in index order
+  std::vector<std::string_view> m_strings;
+};
+
+struct Reader
+{
+  template <typename T>
+  auto read(T* value) -> bool
+  {
+    if (m_bytes.size() < sizeof(T)) return false;
+    std::memcpy(value, m_bytes.data(), sizeof(T));
+    m_bytes.remove_prefix(sizeof(T));
+    return true;
+  }
+
+  // Enums stored are numbered contiguously from zero, so any value below the count is valid
+  template <typename E>
+  auto read_enum(E* value) -> bool
+  {
+    std::underlying_type_t<E> raw;
+    if (!read(&raw) || raw >= magic_enum::enum_count<E>()) return false;
+    *value = static_cast<E>(raw);
+    return true;
+  }
+
+  auto string(std::string_view* str) -> bool
+  {
+    std::uint32_t index;
+    if (!read(&index) || index >= m_strings.size()) return false;
+    *str = m_strings[index];
+    return true;
+  }
+
+  // A name as the lexer would have produced it, interned in the pool
+  auto name(std::uint32_t line) -> std::optional<Token>
+  {
+    std::string_view text;
+    if (!string(&text)) return std::nullopt;
+    auto const symbol = m_pool->intern(text);
+    return Token{TOKEN_TYPE::IDENTIFIER, (*m_pool)[symbol], line, symbol};
+  }
+
+  auto literal() -> std::optional<Value>
+  {
+    LITERAL tag;
+    if (!read_enum(&tag)) return std::nullopt;
+    switch (tag)
+    {
+    case LITERAL::NIL: return Value{};
+    case LITERAL::BOOL:
+    {
+      std::uint8_t b;
+      if (!read(&b)) return std::nullopt;
+      return Value{b != 0};
+    }
+    case LITERAL::NUMBER:
+    {
+      float number;
+      if (!read(&number)) return std::nullopt;
+      return Value{number};
+    }
+    case LITERAL::STRING:
+    {
+      std::string_view str;
+      if (!string(&str)) return std::nullopt;
+      return Value{str};
+    }
+    }
+    return std::nullopt;
+  }
+
+  // Read a node and its children, returning null if the bytes are damaged
+  auto node() -> Expression const*
+  {
+    NODE_KIND kind;
+    std::uint32_t line;
+    if (!read_enum(&kind) || !read(&line)) return nullptr;
+    Expression* expr = nullptr;
+    switch (kind)
+    {
+    case NODE_KIND::DEFINITION:
+    {
+      auto const name = this->name(line);
+      if (!name) return nullptr;
+      auto const value = node();
+      if (!value) return nullptr;
+      expr = m_arena->make<Definition>(*name, value);
+      break;
+    }
+    case NODE_KIND::READ:
+    {
+      auto const name = this->name(line);
+      if (!name) return nullptr;
+      expr = m_arena->make<Read>(*name);
+      break;
+    }
+    case NODE_KIND::STATEMENT:
+    {
+      auto const child = node();
+      if (!child) return nullptr;
+      expr = m_arena->make<Statement>(child);
+      break;
+    }
+    case NODE_KIND::BLOCK:
+    {
+      std::uint32_t count;
+      if (!read(&count)) return nullptr;
+      std::vector<Expression const*> children;
+      for (std::uint32_t i = 0; i < count; ++i)
+      {
+        children.push_back(node());
+        if (!children.back()) return nullptr;
+      }
+      expr = m_arena->make<Block>(m_arena->copy(children));
+      break;
+    }
+    case NODE_KIND::PRINT:
+    {
+      auto const child = node();
+      if (!child) return nullptr;
+      expr = m_arena->make<Print>(child);
+      break;
+    }
+    case NODE_KIND::ASSIGN:
+    {
+      auto const name = this->name(line);
+      if (!name) return nullptr;
+      auto const value = node();
+      if (!value) return nullptr;
+      expr = m_arena->make<Assign>(*name, value);
+      break;
+    }
+    case NODE_KIND::TERNARY:
+    {
+      auto const cond = node();
+      auto const left = cond ? node() : nullptr;
+      auto const right = left ? node() : nullptr;
+      if (!right) return nullptr;
+      expr = m_arena->make<Ternary>(cond, left, right);
+      break;
+    }
+    case NODE_KIND::BINARY:
+    {
+      TOKEN_TYPE op;
+      if (!read_enum(&op)) return nullptr;
+      auto const left = node();
+      auto const right = left ? node() : nullptr;
+      if (!right) return nullptr;
+      expr = m_arena->make<Binary>(left, right, op);
+      break;
+    }
+    case NODE_KIND::GROUP:
+    {
+      auto const child = node();
+      if (!child) return nullptr;
+      expr = m_arena->make<Group>(child);
+      break;
+    }
+    case NODE_KIND::LITERAL:
+    {
+      auto value = literal();
+      if (!value) return nullptr;
+      expr = m_arena->make<Literal>(std::move(*value));
+      break;
+    }
+    case NODE_KIND::UNARY:
+    {
+      TOKEN_TYPE op;
+      if (!read_enum(&op)) return nullptr;
+      auto const child = node();
+      if (!child) return nullptr;
+      expr = m_arena->make<Unary>(child, op);
+      break;
+    }
+    }
+    expr->m_line = line;
+    return expr;
+  }
+
+  std::string_view m_bytes;
+  std::vector<std::string_view> m_strings;
+  Arena* m_arena;
+  StringPool* m_pool;
+};
+}  // namespace
+
+auto content_hash(std::string_view source) -> std::uint64_t
+{
+  // 64 bit FNV-1a
+  std::uint64_t hash = 0xcbf29ce484222325;
+  for (auto const c : source)
+  {
+    hash ^= static_cast<unsigned char>(c);
+    hash *= 0x100000001b3;
+  }
+  return hash;
+}
+
+auto cache_path(std::filesystem::path const& script,
+                std::optional<std::filesystem::path> const& directory,
+                std::string_view source) -> std::filesystem::path
+{
+  if (directory) return *directory / fmt::format("{:016x}.loxc", content_hash(source));
+  auto path = script;
+  path += 'c';
+  return path;
+}
+
+auto serialize(Program const& program, std::string_view source) -> std::string
+{
+  Writer writer;
+  for (auto const& expr : program.m_expressions) expr->accept(writer);
+
+  Header const header{magic,
+                      cache_version,
+                      content_hash(source),
+                      source.size(),
+                      static_cast<std::uint32_t>(writer.m_strings.size()),
+                      static_cast<std::uint32_t>(program.m_expressions.size())};
+  std::string bytes{reinterpret_cast<char const*>(&header), sizeof(header)};
+  for (auto const& str : writer.m_strings)
+  {
+    auto const size = static_cast<std::uint32_t>(str.size());
+    bytes.append(reinterpret_cast<char const*>(&size), sizeof(size)).append(str);
+  }
+  return bytes.append(writer.m_nodes);
+}
+
+auto deserialize(std::string_view bytes, std::string_view source, StringPool* pool) -> std::optional<Program>
+{
+  Program program;
+  Reader reader{bytes, {}, &program.m_arena, pool};
+  Header header;
+  if (!reader.read(&header) || header.m_magic != magic || header.m_version != cache_version ||
+      header.m_size != source.size() || header.m_hash != content_hash(source))
+  {
+    return std::nullopt;
+  }
+  // Every string and node takes at least four bytes, which bounds the counts of a damaged cache
+  if (header.m_strings > reader.m_bytes.size() / 4 || header.m_roots > reader.m_bytes.size() / 4)
+  {
+    return std::nullopt;
+  }
+  reader.m_strings.reserve(header.m_strings);
+  for (std::uint32_t i = 0; i < header.m_strings; ++i)
+  {
+    std::uint32_t size;
+    if (!reader.read(&size) || size > reader.m_bytes.size()) return std::nullopt;
+    reader.m_strings.push_back(reader.m_bytes.substr(0, size));
+    reader.m_bytes.remove_prefix(size);
+  }
+  program.m_expressions.reserve(header.m_roots);
+  for (std::uint32_t i = 0; i < header.m_roots; ++i)
+  {
+    program.m_expressions.push_back(reader.node());
+    if (!program.m_expressions.back()) return std::nullopt;
+  }
+  if (!reader.m_bytes.empty()) return std::nullopt;
+  return program;
+}
+
+auto load_cached(std::filesystem::path const& path, std::string_view source, StringPool* pool)
+  -> std::optional<Program>
+{
+  // A missing cache is the usual reason to fall back to parsing
+  std::error_code ec;
+  if (!std::filesystem::is_regular_file(path, ec)) return std::nullopt;
+  auto const mapped = load_source(path);
+  if (!mapped) return std::nullopt;
+  return deserialize(mapped->view(), source, pool);
+}
+
+auto store_cached(std::filesystem::path const& path, Program const& program, std::string_view source)
+  -> result<void>
+{
+  auto const bytes = serialize(program, source);
+  std::error_code ec;
+  if (path.has_parent_path()) std::filesystem::create_directories(path.parent_path(), ec);
+  // Written beside the destination and renamed over it, which is atomic
+  auto temporary = path;
+  temporary += fmt::format(".{}.{}.tmp", ::getpid(), stores++);
+  {
+    std::ofstream file{temporary, std::ios::binary};
+    file.write(bytes.data(), bytes.size());
+    if (!file)
+    {
+      std::filesystem::remove(temporary, ec);
+      return lox::error(fmt::format("Failed to write the cache '{}'.", path.string()), ~0u);
+    }
+  }
+  std::filesystem::rename(temporary, path, ec);
+  if (ec)
+  {
+    std::filesystem::remove(temporary, ec);
+    return lox::error(fmt::format("Failed to write the cache '{}'.", path.string()), ~0u);
+  }
+  return lox::ok();
+}
+}  // namespace lox
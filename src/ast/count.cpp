@@ -0,0 +1,68 @@
+#include "lox/ast/count.hpp"
+
+namespace lox
+{
+namespace
+{
+struct NodeCount final : public AstVisitor
+{
+  virtual auto visit(Definition const& expr) -> result<void> override
+  {
+    return count(NODE_KIND::DEFINITION, expr.m_value);
+  }
+  virtual auto visit(Read const&) -> result<void> override { return count(NODE_KIND::READ); }
+  virtual auto visit(Statement const& expr) -> result<void> override
+  {
+    return count(NODE_KIND::STATEMENT, expr.m_expression);
+  }
+  virtual auto visit(Block const& expr) -> result<void> override
+  {
+    for (auto const& e : expr.m_expressions) e->accept(*this);
+    return count(NODE_KIND::BLOCK);
+  }
+  virtual auto visit(Print const& expr) -> result<void> override
+  {
+    return count(NODE_KIND::PRINT, expr.m_value);
+  }
+  virtual auto visit(Assign const& expr) -> result<void> override
+  {
+    return count(NODE_KIND::ASSIGN, expr.m_value);
+  }
+  virtual auto visit(Ternary const& expr) -> result<void> override
+  {
+    expr.m_cond->accept(*this);
+    expr.m_left->accept(*this);
+    return count(NODE_KIND::TERNARY, expr.m_right);
+  }
+  virtual auto visit(Binary const& expr) -> result<void> override
+  {
+    expr.m_left->accept(*this);
+    return count(NODE_KIND::BINARY, expr.m_right);
+  }
+  virtual auto visit(Group const& expr) -> result<void> override
+  {
+    return count(NODE_KIND::GROUP, expr.m_expression);
+  }
+  virtual auto visit(Literal const&) -> result<void> override { return count(NODE_KIND::LITERAL); }
+  virtual auto visit(Unary const& expr) -> result<void> override
+  {
+    return count(NODE_KIND::UNARY, expr.m_expression);
+  }
+
+  auto count(NODE_KIND kind, Expression const* child = nullptr) -> result<void>
+  {
+    ++m_counts[magic_enum::enum_integer(kind)];
+    return child ? child->accept(*this) : lox::ok();
+  }
+
+  NodeCounts m_counts{};
+};
+}  // namespace
+
+auto count_nodes(Program const& program) -> NodeCounts
+{
+  NodeCount counter;
+  for (auto const& expr : program.m_expressions) expr->accept(counter);
+  return counter.m_counts;
+}
+}  // namespace lox
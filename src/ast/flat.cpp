@@ -0,0 +1,160 @@
+#include "lox/ast/flat.hpp"
+
+#include <cstring>
+
+namespace lox
+{
+namespace
+{
+// Appends each visited expression to the tree before its children, so that evaluation walks the
+// arrays forwards
+struct Flattener final : public AstVisitor
+{
+  virtual auto visit(Definition const& expr) -> result<void> override
+  {
+    auto const node = add(NODE_KIND::DEFINITION, TOKEN_TYPE::END, expr.m_name.symbol);
+    auto const value = flatten(*expr.m_value);
+    m_ast.m_operands[node] = {value, expr.m_slot};
+    return lox::ok();
+  }
+  virtual auto visit(Read const& expr) -> result<void> override
+  {
+    auto const node = add(NODE_KIND::READ, TOKEN_TYPE::END, expr.m_name.symbol);
+    m_ast.m_operands[node][0] = bind(expr.m_binding);
+    return lox::ok();
+  }
+  virtual auto visit(Statement const& expr) -> result<void> override
+  {
+    return unary(NODE_KIND::STATEMENT, TOKEN_TYPE::END, *expr.m_expression);
+  }
+  virtual auto visit(Block const& expr) -> result<void> override
+  {
+    auto const node = add(NODE_KIND::BLOCK, TOKEN_TYPE::END, expr.m_size);
+    // Children are flattened first, as they may contain blocks of their own
+    std::vector<NodeIndex> children;
+    children.reserve(expr.m_expressions.size());
+    for (auto const& e : expr.m_expressions) children.push_back(flatten(*e));
+    auto const offset = static_cast<NodeIndex>(m_ast.m_lists.size());
+    m_ast.m_lists.insert(m_ast.m_lists.end(), children.begin(), children.end());
+    m_ast.m_operands[node] = {offset, static_cast<NodeIndex>(children.size())};
+    return lox::ok();
+  }
+  virtual auto visit(Print const& expr) -> result<void> override
+  {
+    return unary(NODE_KIND::PRINT, TOKEN_TYPE::END, *expr.m_value);
+  }
+  virtual auto visit(Assign const& expr) -> result<void> override
+  {
+    auto const node = add(NODE_KIND::ASSIGN, TOKEN_TYPE::END, expr.m_name.symbol);
+    auto const value = flatten(*expr.m_value);
+    m_ast.m_operands[node] = {value, bind(expr.m_binding)};
+    return lox::ok();
+  }
+  virtual auto visit(Ternary const& expr) -> result<void> override
+  {
+    auto const node = add(NODE_KIND::TERNARY, TOKEN_TYPE::END, 0);
+    auto const cond = flatten(*expr.m_cond);
+    auto const left = flatten(*expr.m_left);
+    auto const right = flatten(*expr.m_right);
+    m_ast.m_operands[node] = {cond, left};
+    m_ast.m_payloads[node] = right;
+    return lox::ok();
+  }
+  virtual auto visit(Binary const& expr) -> result<void> override
+  {
+    auto const node = add(NODE_KIND::BINARY, expr.m_op, 0);
+    auto const left = flatten(*expr.m_left);
+    auto const right = flatten(*expr.m_right);
+    m_ast.m_operands[node] = {left, right};
+    return lox::ok();
+  }
+  virtual auto visit(Group const& expr) -> result<void> override
+  {
+    return unary(NODE_KIND::GROUP, TOKEN_TYPE::END, *expr.m_expression);
+  }
+  virtual auto visit(Literal const& expr) -> result<void> override
+  {
+    // Only strings need a side table, everything else fits in the operator and payload
+    auto const& value = expr.m_literal;
+    switch (value.type())
+    {
+    case VALUE_TYPE::STRING:
+    {
+      add(NODE_KIND::LITERAL, TOKEN_TYPE::STRING, static_cast<std::uint32_t>(m_ast.m_strings.size()));
+      m_ast.m_strings.push_back(value);
+      break;
+    }
+    case VALUE_TYPE::NUMBER:
+    {
+      auto const number = value.as_number();
+      std::uint32_t bits;
+      std::memcpy(&bits, &number, sizeof(bits));
+      add(NODE_KIND::LITERAL, TOKEN_TYPE::NUMBER, bits);
+      break;
+    }
+    case VALUE_TYPE::BOOL:
+    {
+      add(NODE_KIND::LITERAL, value.as_bool() ? TOKEN_TYPE::TRUE : TOKEN_TYPE::FALSE, 0);
+      break;
+    }
+    case VALUE_TYPE::NIL: add(NODE_KIND::LITERAL, TOKEN_TYPE::NIL, 0); break;
+    }
+    return lox::ok();
+  }
+  virtual auto visit(Unary const& expr) -> result<void> override
+  {
+    return unary(NODE_KIND::UNARY, expr.m_op, *expr.m_expression);
+  }
+
+  auto add(NODE_KIND kind, TOKEN_TYPE op, std::uint32_t payload) -> NodeIndex
+  {
+    m_ast.m_kinds.push_back(kind);
+    m_ast.m_ops.push_back(op);
+    m_ast.m_operands.push_back({0, 0});
+    m_ast.m_payloads.push_back(payload);
+    return static_cast<NodeIndex>(m_ast.m_kinds.size() - 1);
+  }
+
+  auto unary(NODE_KIND kind, TOKEN_TYPE op, Expression const& child) -> result<void>
+  {
+    auto const node = add(kind, op, 0);
+    m_ast.m_operands[node][0] = flatten(child);
+    return lox::ok();
+  }
+
+  auto bind(Binding binding) -> std::uint32_t
+  {
+    m_ast.m_bindings.push_back(binding);
+    return static_cast<std::uint32_t>(m_ast.m_bindings.size() - 1);
+  }
+
+  auto flatten(Expression const& expr) -> NodeIndex
+  {
+    auto const node = static_cast<NodeIndex>(m_ast.size());
+    expr.accept(*this);
+    return node;
+  }
+
+  FlatAst m_ast;
+};
+}  // namespace
+
+auto FlatAst::size_bytes() const -> std::size_t
+{
+  return m_kinds.size() * sizeof(NODE_KIND) + m_ops.size() * sizeof(TOKEN_TYPE) +
+         m_operands.size() * sizeof(m_operands[0]) + m_payloads.size() * sizeof(m_payloads[0]) +
+         m_lists.size() * sizeof(NodeIndex) + m_strings.size() * sizeof(Value) +
+         m_bindings.size() * sizeof(Binding) + m_roots.size() * sizeof(NodeIndex);
+}
+
+auto flatten(Program const& program, StringPool const* pool) -> FlatAst
+{
+  Flattener flattener;
+  flattener.m_ast.m_names = pool;
+  for (auto const& expr : program.m_expressions)
+  {
+    flattener.m_ast.m_roots.push_back(flattener.flatten(*expr));
+  }
+  return std::move(flattener.m_ast);
+}
+}  // namespace lox
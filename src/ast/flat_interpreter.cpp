@@ -0,0 +1,103 @@
+#include "lox/ast/flat_interpreter.hpp"
+
+#include <fmt/format.h>
+
+#include <cstring>
+
+#include "lox/operators.hpp"
+#include "lox/output.hpp"
+
+namespace lox
+{
+auto FlatInterpreter::evaluate(FlatAst const& ast, NodeIndex node) -> lox::result<void>
+{
+  auto const [first, second] = ast.m_operands[node];
+  auto const payload = ast.m_payloads[node];
+  auto const name = [&] { return (*ast.m_names)[payload]; };
+  switch (ast.m_kinds[node])
+  {
+  case NODE_KIND::DEFINITION:
+  {
+    if (auto value = evaluate(ast, first); !value.has_value()) return value;
+    environment.define(second, Environment::Value{result});
+    return lox::ok();
+  }
+  case NODE_KIND::READ:
+  {
+    auto value = environment.lookup(ast.m_bindings[first], name());
+    if (!value.has_value()) return lox::error(value.error());
+    result = (*value)->value;
+    return lox::ok();
+  }
+  case NODE_KIND::STATEMENT:
+  {
+    if (auto value = evaluate(ast, first); !value.has_value()) return value;
+    result = std::monostate{};
+    return lox::ok();
+  }
+  case NODE_KIND::BLOCK:
+  {
+    environment.push_scope(payload);
+    // As with the tree, errors inside a block don't escape it
+    for (auto child = first; child != first + second; ++child) evaluate(ast, ast.m_lists[child]);
+    environment.pop_scope();
+    return lox::ok();
+  }
+  case NODE_KIND::PRINT:
+  {
+    if (auto value = evaluate(ast, first); !value.has_value()) return value;
+    lox::print("{}\n", result);
+    result = std::monostate{};
+    return lox::ok();
+  }
+  case NODE_KIND::ASSIGN:
+  {
+    if (auto value = evaluate(ast, first); !value.has_value()) return value;
+    return environment.assign(ast.m_bindings[second], name(), Environment::Value{result});
+  }
+  case NODE_KIND::TERNARY:
+  {
+    if (auto cond = evaluate(ast, first); !cond.has_value()) return cond;
+    return evaluate(ast, Truth{}(result) ? second : payload);
+  }
+  case NODE_KIND::BINARY:
+  {
+    if (auto left = evaluate(ast, first); !left.has_value()) return left;
+    auto const lhs = result;
+    if (auto right = evaluate(ast, second); !right.has_value()) return right;
+    auto evaluated = binary(ast.m_ops[node], lhs, result);
+    if (!evaluated) return lox::error(evaluated.error());
+    result = std::move(*evaluated);
+    return lox::ok();
+  }
+  case NODE_KIND::GROUP: return evaluate(ast, first);
+  case NODE_KIND::LITERAL:
+  {
+    switch (ast.m_ops[node])
+    {
+    case TOKEN_TYPE::STRING: result = ast.m_strings[payload]; break;
+    case TOKEN_TYPE::NUMBER:
+    {
+      float value;
+      std::memcpy(&value, &payload, sizeof(value));
+      result = value;
+      break;
+    }
+    case TOKEN_TYPE::TRUE: result = true; break;
+    case TOKEN_TYPE::FALSE: result = false; break;
+    default: result = std::monostate{}; break;
+    }
+    return lox::ok();
+  }
+  case NODE_KIND::UNARY:
+  {
+    if (auto operand = evaluate(ast, first); !operand.has_value()) return operand;
+    auto evaluated = unary(ast.m_ops[node], result);
+    if (!evaluated) return lox::error(evaluated.error());
+    result = std::move(*evaluated);
+    return lox::ok();
+  }
+  }
+  return lox::error("Unhandled node kind.", ~0u);
+}
+}  // namespace lox
@@ -0,0 +1,149 @@
+#include "lox/ast/optimize.hpp"
+
+#include <vector>
+
+#include "lox/ast/count.hpp"
+#include "lox/operators.hpp"
+
+namespace lox
+{
+namespace
+{
+// Rebuilds each visited expression bottom up, leaving the replacement in m_node. Nodes whose
+// children are unchanged are reused rather than copied.
+struct Optimizer final : public AstVisitor
+{
+  virtual auto visit(Definition const& expr) -> result<void> override
+  {
+    auto const value = optimize(expr.m_value);
+    return replace(value == expr.m_value ? &expr : rebuild<Definition>(expr, expr.m_name, value), m_valued);
+  }
+  virtual auto visit(Read const& expr) -> result<void> override { return replace(&expr); }
+  virtual auto visit(Statement const& expr) -> result<void> override
+  {
+    auto const child = optimize(expr.m_expression);
+    return replace(child == expr.m_expression ? &expr : rebuild<Statement>(expr, child));
+  }
+  virtual auto visit(Block const& expr) -> result<void> override
+  {
+    std::vector<Expression const*> children;
+    children.reserve(expr.m_expressions.size());
+    bool changed = false;
+    for (auto const& e : expr.m_expressions)
+    {
+      children.push_back(optimize(e));
+      changed |= children.back() != e;
+    }
+    // An empty block sets no value, leaving whatever was evaluated before it as the result
+    return replace(changed ? rebuild<Block>(expr, m_arena->copy(children)) : &expr, false);
+  }
+  virtual auto visit(Print const& expr) -> result<void> override
+  {
+    auto const value = optimize(expr.m_value);
+    return replace(value == expr.m_value ? &expr : rebuild<Print>(expr, value));
+  }
+  virtual auto visit(Assign const& expr) -> result<void> override
+  {
+    auto const value = optimize(expr.m_value);
+    return replace(value == expr.m_value ? &expr : rebuild<Assign>(expr, expr.m_name, value), m_valued);
+  }
+  virtual auto visit(Ternary const& expr) -> result<void> override
+  {
+    auto const cond = optimize(expr.m_cond);
+    // Only the branch taken would ever have been evaluated. Unless it sets a value of its own the
+    // condition's value is the result, so the test has to stay.
+    if (auto const constant = m_constant)
+    {
+      if (optimize(Truth{}(constant->m_literal) ? expr.m_left : expr.m_right); m_valued) return lox::ok();
+    }
+    auto const left = optimize(expr.m_left);
+    auto const valued = m_valued;
+    auto const right = optimize(expr.m_right);
+    auto const same = cond == expr.m_cond && left == expr.m_left && right == expr.m_right;
+    return replace(same ? &expr : rebuild<Ternary>(expr, cond, left, right), valued && m_valued);
+  }
+  virtual auto visit(Binary const& expr) -> result<void> override
+  {
+    auto const left = optimize(expr.m_left);
+    auto const lhs = m_constant;
+    auto const right = optimize(expr.m_right);
+    auto const rhs = m_constant;
+    if (lhs && rhs)
+    {
+      if (auto folded = binary(expr.m_op, lhs->m_literal, rhs->m_literal))
+      {
+        return constant(rebuild<Literal>(expr, std::move(*folded)));
+      }
+    }
+    auto const same = left == expr.m_left && right == expr.m_right;
+    return replace(same ? &expr : rebuild<Binary>(expr, left, right, expr.m_op));
+  }
+  virtual auto visit(Group const& expr) -> result<void> override
+  {
+    // Evaluating a group is exactly evaluating its child, which is left in m_node and m_valued
+    optimize(expr.m_expression);
+    return lox::ok();
+  }
+  virtual auto visit(Literal const& expr) -> result<void> override { return constant(&expr); }
+  virtual auto visit(Unary const& expr) -> result<void> override
+  {
+    auto const child = optimize(expr.m_expression);
+    if (auto const operand = m_constant)
+    {
+      if (auto folded = unary(expr.m_op, operand->m_literal))
+      {
+        return constant(rebuild<Literal>(expr, std::move(*folded)));
+      }
+    }
+    return replace(child == expr.m_expression ? &expr : rebuild<Unary>(expr, child, expr.m_op));
+  }
+
+  // Make a node replacing original, at the same source line
+  template <typename T, typename... Args>
+  auto rebuild(Expression const& original, Args&&... args) -> T const*
+  {
+    auto node = m_arena->make<T>(std::forward<Args>(args)...);
+    node->m_line = original.m_line;
+    return node;
+  }
+
+  auto optimize(Expression const* expr) -> Expression const*
+  {
+    expr->accept(*this);
+    return m_node;
+  }
+
+  auto replace(Expression const* node, bool valued = true) -> result<void>
+  {
+    m_node = node;
+    m_constant = nullptr;
+    m_valued = valued;
+    return lox::ok();
+  }
+
+  auto constant(Literal const* literal) -> result<void>
+  {
+    m_node = literal;
+    m_constant = literal;
+    m_valued = true;
+    return lox::ok();
+  }
+
+  Arena* m_arena;
+  // Replacement for the last visited expression, and the same node if it is a literal
+  Expression const* m_node = nullptr;
+  Literal const* m_constant = nullptr;
+  // Whether evaluating m_node always sets the result, rather than leaving whatever was evaluated last
+  bool m_valued = true;
+};
+}  // namespace
+
+auto optimize(Program* program) -> std::size_t
+{
+  auto const before = total(count_nodes(*program));
+  Optimizer optimizer;
+  optimizer.m_arena = &program->m_arena;
+  for (auto& expr : program->m_expressions) expr = optimizer.optimize(expr);
+  return before - total(count_nodes(*program));
+}
+}  // namespace lox
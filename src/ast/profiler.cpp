@@ -0,0 +1,95 @@
+#include "lox/ast/profiler.hpp"
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <fstream>
+#include <utility>
+
+#include "lox/output.hpp"
+
+namespace lox
+{
+namespace
+{
+auto milliseconds(Profiler::clock::duration time) -> double
+{
+  return std::chrono::duration<double, std::milli>(time).count();
+}
+
+auto percent(Profiler::clock::duration time, Profiler::clock::duration total) -> double
+{
+  return total.count() ? 100.0 * time.count() / total.count() : 0.0;
+}
+
+auto hottest_first(std::pair<std::string, Profiler::Sample> const& lhs,
+                   std::pair<std::string, Profiler::Sample> const& rhs) -> bool
+{
+  return lhs.second.m_time > rhs.second.m_time;
+}
+
+auto print_table(std::vector<std::pair<std::string, Profiler::Sample>> rows,
+                 Profiler::clock::duration total,
+                 std::size_t limit) -> void
+{
+  std::sort(rows.begin(), rows.end(), hottest_first);
+  lox::print("  {:<12} {:>12} {:>12} {:>7}\n", "", "count", "self ms", "%");
+  for (std::size_t i = 0; i < std::min(limit, rows.size()); ++i)
+  {
+    auto const& [name, sample] = rows[i];
+    lox::print("  {:<12} {:>12} {:>12.3f} {:>6.1f}%\n",
+               name,
+               sample.m_count,
+               milliseconds(sample.m_time),
+               percent(sample.m_time, total));
+  }
+}
+}  // namespace
+
+auto Profiler::report(std::size_t lines) const -> void
+{
+  std::vector<std::pair<std::string, Sample>> kinds;
+  clock::duration total{};
+  std::uint64_t count = 0;
+  for (std::size_t i = 0; i < m_kinds.size(); ++i)
+  {
+    if (!m_kinds[i].m_count) continue;
+    kinds.emplace_back(magic_enum::enum_name(static_cast<NODE_KIND>(i)), m_kinds[i]);
+    total += m_kinds[i].m_time;
+    count += m_kinds[i].m_count;
+  }
+  lox::print("Profile: {} nodes executed in {:.3f} ms\n", count, milliseconds(total));
+  lox::print("By node kind:\n");
+  print_table(std::move(kinds), total, m_kinds.size());
+
+  std::vector<std::pair<std::string, Sample>> rows;
+  rows.reserve(m_lines.size());
+  for (auto const& [line, sample] : m_lines) rows.emplace_back(fmt::format("line {}", line), sample);
+  lox::print("By line, hottest {}:\n", std::min(lines, rows.size()));
+  print_table(std::move(rows), total, lines);
+}
+
+auto Profiler::write_stacks(std::filesystem::path const& path) const -> result<void>
+{
+  std::ofstream file{path};
+  if (!file) return lox::error(fmt::format("Could not open '{}' to write the profile.", path.string()), ~0u);
+  for (auto const& [stack, time] : m_stacks)
+  {
+    // Nanoseconds, as the tools expect integer sample counts
+    file << stack << ' ' << std::chrono::duration_cast<std::chrono::nanoseconds>(time).count() << '\n';
+  }
+  if (!file) return lox::error(fmt::format("Failed to write the profile to '{}'.", path.string()), ~0u);
+  return lox::ok();
+}
+
+auto Profiler::record_stack(clock::duration self) -> void
+{
+  std::string stack;
+  for (auto const& frame : m_stack)
+  {
+    if (!stack.empty()) stack += ';';
+    stack += fmt::format("{}:{}", magic_enum::enum_name(frame.m_kind), frame.m_line);
+  }
+  m_stacks[stack] += self;
+}
+}  // namespace lox
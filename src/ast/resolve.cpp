@@ -0,0 +1,104 @@
+#include "lox/ast/resolve.hpp"
+
+#include <string_view>
+#include <vector>
+
+namespace lox
+{
+namespace
+{
+// Walks the program in evaluation order, so a name is only visible to accesses after its
+// declaration, exactly as it would be when looked up at runtime
+struct Binder final : public AstVisitor
+{
+  virtual auto visit(Definition const& expr) -> result<void> override
+  {
+    // The value can't see the variable it initialises
+    expr.m_value->accept(*this);
+    expr.m_slot = declare(expr.m_name.lexeme);
+    return lox::ok();
+  }
+  virtual auto visit(Read const& expr) -> result<void> override
+  {
+    expr.m_binding = bind(expr.m_name.lexeme);
+    return lox::ok();
+  }
+  virtual auto visit(Statement const& expr) -> result<void> override
+  {
+    return expr.m_expression->accept(*this);
+  }
+  virtual auto visit(Block const& expr) -> result<void> override
+  {
+    m_scopes.emplace_back();
+    for (auto const& e : expr.m_expressions) e->accept(*this);
+    expr.m_size = static_cast<std::uint32_t>(m_scopes.back().size());
+    m_scopes.pop_back();
+    return lox::ok();
+  }
+  virtual auto visit(Print const& expr) -> result<void> override { return expr.m_value->accept(*this); }
+  virtual auto visit(Assign const& expr) -> result<void> override
+  {
+    expr.m_value->accept(*this);
+    expr.m_binding = bind(expr.m_name.lexeme);
+    return lox::ok();
+  }
+  virtual auto visit(Ternary const& expr) -> result<void> override
+  {
+    expr.m_cond->accept(*this);
+    expr.m_left->accept(*this);
+    return expr.m_right->accept(*this);
+  }
+  virtual auto visit(Binary const& expr) -> result<void> override
+  {
+    expr.m_left->accept(*this);
+    return expr.m_right->accept(*this);
+  }
+  virtual auto visit(Group const& expr) -> result<void> override { return expr.m_expression->accept(*this); }
+  virtual auto visit(Literal const&) -> result<void> override { return lox::ok(); }
+  virtual auto visit(Unary const& expr) -> result<void> override { return expr.m_expression->accept(*this); }
+
+  // Redeclaring a name in the same scope reuses its slot, overwriting the variable
+  auto declare(std::string_view name) -> std::uint32_t
+  {
+    if (m_scopes.empty())
+    {
+      auto const next = static_cast<std::uint32_t>(m_globals->size());
+      return m_globals->try_emplace(std::string{name}, next).first->second;
+    }
+    auto& scope = m_scopes.back();
+    auto const next = static_cast<std::uint32_t>(scope.size());
+    return scope.try_emplace(name, next).first->second;
+  }
+
+  auto bind(std::string_view name) -> Binding
+  {
+    m_slots.clear();
+    auto depth = std::uint32_t{0};
+    for (auto scope = m_scopes.rbegin(); scope != m_scopes.rend(); ++scope, ++depth)
+    {
+      if (auto found = scope->find(name); found != scope->end()) m_slots.push_back({depth, found->second});
+    }
+    if (auto found = m_globals->find(std::string{name}); found != m_globals->end())
+    {
+      m_slots.push_back({depth, found->second});
+    }
+    if (m_slots.empty()) return {};
+    return m_arena->copy(m_slots);
+  }
+
+  Arena* m_arena;
+  std::unordered_map<std::string, std::uint32_t>* m_globals;
+  // Variables declared so far in each enclosing block, innermost last
+  std::vector<std::unordered_map<std::string_view, std::uint32_t>> m_scopes;
+  std::vector<Slot> m_slots;
+};
+}  // namespace
+
+auto Resolver::resolve(Program* program) -> void
+{
+  Binder binder;
+  binder.m_arena = &program->m_arena;
+  binder.m_globals = &m_globals;
+  for (auto const& expr : program->m_expressions) expr->accept(binder);
+}
+}  // namespace lox
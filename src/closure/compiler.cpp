@@ -0,0 +1,230 @@
+#include "lox/closure/compiler.hpp"
+
+#include <fmt/format.h>
+
+#include <functional>
+#include <string_view>
+#include <utility>
+
+#include "lox/operators.hpp"
+#include "lox/output.hpp"
+
+namespace lox
+{
+namespace
+{
+// Wraps an operation on two numbers, which declines any other operands
+template <typename Op>
+auto numeric(Op op)
+{
+  return [op](Value const& lhs, Value* rhs) {
+    if (!lhs.is_number() || !rhs->is_number()) return false;
+    *rhs = op(lhs.as_number(), rhs->as_number());
+    return true;
+  };
+}
+
+// Evaluate both operands, then combine them with fast, which leaves its value in place of the right
+// hand side. Operands which fast declines go to the generic operator, so they fail identically.
+template <typename Fast>
+auto binary_closure(TOKEN_TYPE op, Closure left, Closure right, Fast fast) -> Closure
+{
+  return [op, left = std::move(left), right = std::move(right), fast](ClosureInterpreter& in) {
+    if (auto evaluated = left(in); !evaluated) return evaluated;
+    // Copied, as an empty block on the right leaves result unchanged
+    auto const lhs = in.result;
+    if (auto evaluated = right(in); !evaluated) return evaluated;
+    if (fast(lhs, &in.result)) return lox::ok();
+    auto evaluated = binary(op, lhs, in.result);
+    if (!evaluated) return lox::result<void>{lox::error(evaluated.error())};
+    in.result = std::move(*evaluated);
+    return lox::ok();
+  };
+}
+
+// Builds the closure for each visited expression in m_closure, mirroring Interpreter::visit
+struct ClosureCompiler final : public AstVisitor
+{
+  virtual auto visit(Definition const& expr) -> result<void> override
+  {
+    return set([value = compile(*expr.m_value), slot = expr.m_slot](ClosureInterpreter& in) {
+      if (auto evaluated = value(in); !evaluated) return evaluated;
+      in.environment.define(slot, Environment::Value{in.result});
+      return lox::ok();
+    });
+  }
+  virtual auto visit(Read const& expr) -> result<void> override
+  {
+    return set([binding = expr.m_binding, name = expr.m_name.lexeme](ClosureInterpreter& in) {
+      auto value = in.environment.lookup(binding, name);
+      if (!value) return lox::result<void>{lox::error(value.error())};
+      in.result = (*value)->value;
+      return lox::ok();
+    });
+  }
+  virtual auto visit(Statement const& expr) -> result<void> override
+  {
+    return set([expression = compile(*expr.m_expression)](ClosureInterpreter& in) {
+      if (auto evaluated = expression(in); !evaluated) return evaluated;
+      in.result = std::monostate{};
+      return lox::ok();
+    });
+  }
+  virtual auto visit(Block const& expr) -> result<void> override
+  {
+    std::vector<Closure> children;
+    children.reserve(expr.m_expressions.size());
+    for (auto const& e : expr.m_expressions) children.push_back(compile(*e));
+    return set([children = std::move(children), size = expr.m_size](ClosureInterpreter& in) {
+      in.environment.push_scope(size);
+      // Errors inside a block don't escape it
+      for (auto const& child : children) child(in);
+      in.environment.pop_scope();
+      return lox::ok();
+    });
+  }
+  virtual auto visit(Print const& expr) -> result<void> override
+  {
+    return set([value = compile(*expr.m_value)](ClosureInterpreter& in) {
+      if (auto evaluated = value(in); !evaluated) return evaluated;
+      lox::print("{}\n", in.result);
+      in.result = std::monostate{};
+      return lox::ok();
+    });
+  }
+  virtual auto visit(Assign const& expr) -> result<void> override
+  {
+    return set([value = compile(*expr.m_value), binding = expr.m_binding, name = expr.m_name.lexeme](
+                 ClosureInterpreter& in) {
+      if (auto evaluated = value(in); !evaluated) return evaluated;
+      return in.environment.assign(binding, name, Environment::Value{in.result});
+    });
+  }
+  virtual auto visit(Ternary const& expr) -> result<void> override
+  {
+    return set([cond = compile(*expr.m_cond), left = compile(*expr.m_left), right = compile(*expr.m_right)](
+                 ClosureInterpreter& in) {
+      if (auto evaluated = cond(in); !evaluated) return evaluated;
+      return Truth{}(in.result) ? left(in) : right(in);
+    });
+  }
+  virtual auto visit(Binary const& expr) -> result<void> override
+  {
+    auto const op = expr.m_op;
+    auto left = compile(*expr.m_left);
+    auto right = compile(*expr.m_right);
+    switch (op)
+    {
+    case TOKEN_TYPE::PLUS: return set(binary_closure(op, std::move(left), std::move(right), numeric(std::plus<>{})));
+    case TOKEN_TYPE::MINUS:
+      return set(binary_closure(op, std::move(left), std::move(right), numeric(std::minus<>{})));
+    case TOKEN_TYPE::STAR:
+      return set(binary_closure(op, std::move(left), std::move(right), numeric(std::multiplies<>{})));
+    case TOKEN_TYPE::SLASH:
+    {
+      // Division by zero is left to the generic operator to report
+      auto const divide = [](Value const& lhs, Value* rhs) {
+        return !(rhs->is_number() && rhs->as_number() == 0.f) && numeric(std::divides<>{})(lhs, rhs);
+      };
+      return set(binary_closure(op, std::move(left), std::move(right), divide));
+    }
+    case TOKEN_TYPE::GREATER:
+      return set(binary_closure(op, std::move(left), std::move(right), numeric(std::greater<>{})));
+    case TOKEN_TYPE::GREATER_EQUAL:
+      return set(binary_closure(op, std::move(left), std::move(right), numeric(std::greater_equal<>{})));
+    case TOKEN_TYPE::LESS: return set(binary_closure(op, std::move(left), std::move(right), numeric(std::less<>{})));
+    case TOKEN_TYPE::LESS_EQUAL:
+      return set(binary_closure(op, std::move(left), std::move(right), numeric(std::less_equal<>{})));
+    case TOKEN_TYPE::EQUAL:
+    {
+      auto const equal = [](Value const& lhs, Value* rhs) {
+        *rhs = lhs == *rhs;
+        return true;
+      };
+      return set(binary_closure(op, std::move(left), std::move(right), equal));
+    }
+    case TOKEN_TYPE::BANG_EQUAL:
+    {
+      auto const not_equal = [](Value const& lhs, Value* rhs) {
+        *rhs = lhs != *rhs;
+        return true;
+      };
+      return set(binary_closure(op, std::move(left), std::move(right), not_equal));
+    }
+    case TOKEN_TYPE::COMMA:
+    {
+      // The value is the right hand side, which is already in result
+      return set([left = std::move(left), right = std::move(right)](ClosureInterpreter& in) {
+        if (auto evaluated = left(in); !evaluated) return evaluated;
+        return right(in);
+      });
+    }
+    default:
+    {
+      auto const generic = [](Value const&, Value*) { return false; };
+      return set(binary_closure(op, std::move(left), std::move(right), generic));
+    }
+    }
+  }
+  virtual auto visit(Group const& expr) -> result<void> override
+  {
+    m_closure = compile(*expr.m_expression);
+    return lox::ok();
+  }
+  virtual auto visit(Literal const& expr) -> result<void> override
+  {
+    return set([value = expr.m_literal](ClosureInterpreter& in) {
+      in.result = value;
+      return lox::ok();
+    });
+  }
+  virtual auto visit(Unary const& expr) -> result<void> override
+  {
+    auto operand = compile(*expr.m_expression);
+    if (expr.m_op == TOKEN_TYPE::BANG)
+    {
+      return set([operand = std::move(operand)](ClosureInterpreter& in) {
+        if (auto evaluated = operand(in); !evaluated) return evaluated;
+        in.result = !Truth{}(in.result);
+        return lox::ok();
+      });
+    }
+    return set([operand = std::move(operand), op = expr.m_op](ClosureInterpreter& in) {
+      if (auto evaluated = operand(in); !evaluated) return evaluated;
+      if (op == TOKEN_TYPE::MINUS && in.result.is_number())
+      {
+        in.result = -in.result.as_number();
+        return lox::ok();
+      }
+      auto evaluated = unary(op, in.result);
+      if (!evaluated) return lox::result<void>{lox::error(evaluated.error())};
+      in.result = std::move(*evaluated);
+      return lox::ok();
+    });
+  }
+
+  auto compile(Expression const& expr) -> Closure
+  {
+    expr.accept(*this);
+    return std::move(m_closure);
+  }
+
+  auto set(Closure closure) -> result<void>
+  {
+    m_closure = std::move(closure);
+    return lox::ok();
+  }
+
+  Closure m_closure;
+};
+}  // namespace
+
+auto compile_closures(Program const& program) -> ClosureProgram
+{
+  ClosureCompiler compiler;
+  ClosureProgram compiled;
+  compiled.m_roots.reserve(program.m_expressions.size());
+  for (auto const& expr : program.m_expressions) compiled.m_roots.push_back(compiler.compile(*expr));
+  return compiled;
+}
+}  // namespace lox
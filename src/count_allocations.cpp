@@ -0,0 +1,15 @@
+#include <cstdlib>
+#include <new>
+
+#include "lox/allocation.hpp"
+
+// Replaces the global operator new so that lox::allocations() can count every allocation. Until counting
+// is turned on, allocations only pay for checking that it is off.
+auto operator new(std::size_t size) -> void*
+{
+  lox::count_allocation(size);
+  if (auto const p = std::malloc(size ? size : 1)) return p;
+  throw std::bad_alloc{};
+}
+auto operator delete(void* p) noexcept -> void { std::free(p); }
+auto operator delete(void* p, std::size_t) noexcept -> void { std::free(p); }
@@ -1,10 +1,24 @@
 #include "lox/error.hpp"
-#include <fmt/format.h>
+#include "lox/output.hpp"
 
 namespace lox
 {
+auto Error::describe() const -> std::string
+{
+  switch (code)
+  {
+  case ERROR_CODE::MISMATCHED_TYPES: return fmt::format("Mismatched types for {} expression.", op);
+  case ERROR_CODE::EXPECTED_NUMBERS: return fmt::format("Expected number operands for {} expression.", op);
+  case ERROR_CODE::EXPECTED_NUMBER_OPERAND: return fmt::format("Expected number as operand to {}.", op);
+  case ERROR_CODE::DIVISION_BY_ZERO: return "Division by zero is prohibited.";
+  case ERROR_CODE::UNHANDLED_BINARY: return "Unhandled binary op. FIXME: Error handle this properly";
+  case ERROR_CODE::UNHANDLED_UNARY: return fmt::format("Unhandled unary op {}.", op);
+  default: return message;
+  }
+}
+
 auto report(Error const& error) -> void
 {
-  fmt::print("[line {0}] Error {1}: {2}\n", error.line, "", error.message);
+  lox::print("[line {0}] Error {1}: {2}\n", error.line, "", error.describe());
 }
 }
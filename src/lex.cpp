@@ -2,11 +2,15 @@
 
 #include <fmt/format.h>
 
+#include <algorithm>
+#include <array>
 #include <charconv>
 #include <ctre/ctre.hpp>
 #include <magic_enum/magic_enum.hpp>
 
 #include "lox/ctu.hpp"
+#include "lox/keyword.hpp"
+#include "lox/simd.hpp"
 
 namespace lox
 {
@@ -39,22 +43,6 @@ template<> constexpr std::string_view match<TOKEN_TYPE::LESS_EQUAL> = R"(<=)";
 template<> constexpr std::string_view match<TOKEN_TYPE::GREATER> = R"(>)";
 template<> constexpr std::string_view match<TOKEN_TYPE::LESS> = R"(<)";
 template<> constexpr std::string_view match<TOKEN_TYPE::ASSIGN> = R"(=)";
-template<> constexpr std::string_view match<TOKEN_TYPE::AND> = R"(and(?=\W|$))";
-template<> constexpr std::string_view match<TOKEN_TYPE::STRUCT> = R"(struct(?=\W|$))";
-template<> constexpr std::string_view match<TOKEN_TYPE::ELSE> = R"(else(?=\W|$))";
-template<> constexpr std::string_view match<TOKEN_TYPE::FUN> = R"(fun(?=\W|$))";
-template<> constexpr std::string_view match<TOKEN_TYPE::FOR> = R"(for(?=\W|$))";
-template<> constexpr std::string_view match<TOKEN_TYPE::IF> = R"(if(?=\W|$))";
-template<> constexpr std::string_view match<TOKEN_TYPE::NIL> = R"(nil(?=\W|$))";
-template<> constexpr std::string_view match<TOKEN_TYPE::OR> = R"(or(?=\W|$))";
-template<> constexpr std::string_view match<TOKEN_TYPE::PRINT> = R"(print(?=\W|$))";
-template<> constexpr std::string_view match<TOKEN_TYPE::RETURN> = R"(return(?=\W|$))";
-template<> constexpr std::string_view match<TOKEN_TYPE::SUPER> = R"(super(?=\W|$))";
-template<> constexpr std::string_view match<TOKEN_TYPE::THIS> = R"(this(?=\W|$))";
-template<> constexpr std::string_view match<TOKEN_TYPE::TRUE> = R"(true(?=\W|$))";
-template<> constexpr std::string_view match<TOKEN_TYPE::FALSE> = R"(false(?=\W|$))";
-template<> constexpr std::string_view match<TOKEN_TYPE::VAR> = R"(var(?=\W|$))";
-template<> constexpr std::string_view match<TOKEN_TYPE::WHILE> = R"(while(?=\W|$))";
 template<> constexpr std::string_view match<TOKEN_TYPE::IDENTIFIER> = R"([a-zA-Z_]+\w*)";
 template<> constexpr std::string_view match<TOKEN_TYPE::STRING> = R"("[^"]*")";
 template<> constexpr std::string_view match<TOKEN_TYPE::NUMBER> = R"([0-9]+(?:\.[0-9]+)?)";
@@ -79,16 +67,26 @@ struct PatternGenerator
                 terminate>::value;
 };
 
+// Keywords are matched as identifiers and classified afterwards, so have no pattern of their own
+static constexpr auto lexed_types = [] {
+  std::array<TOKEN_TYPE, magic_enum::enum_count<TOKEN_TYPE>() - 1 - keyword::count> types{};
+  std::size_t i = 0;
+  for (auto type : magic_enum::enum_values<TOKEN_TYPE>())
+  {
+    if (type != TOKEN_TYPE::END && !keyword::contains(type)) types[i++] = type;
+  }
+  return types;
+}();
+
 template <typename>
 struct make_pattern;
 template <std::size_t... I>
 struct make_pattern<std::index_sequence<I...>>
 {
-  static constexpr auto value = PatternGenerator<match<magic_enum::enum_value<TOKEN_TYPE>(I)>...>::value;
+  static constexpr auto value = PatternGenerator<match<lexed_types[I]>...>::value;
 };
 
-static constexpr auto full =
-  make_pattern<std::make_index_sequence<magic_enum::enum_count<TOKEN_TYPE>() - 1>>::value;
+static constexpr auto full = make_pattern<std::make_index_sequence<lexed_types.size()>>::value;
 }  // namespace pattern
 
 namespace impl
@@ -110,46 +108,79 @@ constexpr decltype(auto) indexed_apply(F&& f, T&& t)
                              std::make_index_sequence<std::tuple_size_v<std::remove_reference_t<T>>>{});
 }
 
+// Fill in the payload of a freshly lexed token
 template <TOKEN_TYPE>
 struct ParseLiteral
 {
-  constexpr auto operator()(std::string_view) const -> std::monostate { return std::monostate{}; }
+  constexpr auto operator()(Token&, StringPool*) const -> void {}
 };
 template <>
 struct ParseLiteral<TOKEN_TYPE::NUMBER>
 {
-  auto operator()(std::string_view src) const -> float { return std::stof(std::string{src}); }
+  auto operator()(Token& token, StringPool*) const -> void
+  {
+    auto const& src = token.lexeme;
+    std::from_chars(src.data(), src.data() + src.size(), token.number);
+  }
 };
 template <>
 struct ParseLiteral<TOKEN_TYPE::STRING>
 {
-  auto operator()(std::string_view src) const -> std::string
+  auto operator()(Token& token, StringPool* pool) const -> void
   {
-    return std::string{src.substr(1, src.size() - 2)};
+    token.symbol = pool->intern(token.lexeme.substr(1, token.lexeme.size() - 2));
   }
 };
 template <>
-struct ParseLiteral<TOKEN_TYPE::TRUE>
+struct ParseLiteral<TOKEN_TYPE::IDENTIFIER>
 {
-  auto operator()(std::string_view) const -> bool { return true; }
+  auto operator()(Token& token, StringPool* pool) const -> void { token.symbol = pool->intern(token.lexeme); }
 };
-template <>
-struct ParseLiteral<TOKEN_TYPE::FALSE>
+
+// Runtime lookup of the literal parser for a token type, for when the type of a token is only known
+// once it has been scanned
+template <std::size_t... I>
+constexpr auto make_literal_parsers(std::index_sequence<I...>)
 {
-  auto operator()(std::string_view) const -> bool { return false; }
-};
+  using parser = auto (*)(Token&, StringPool*)->void;
+  return std::array<parser, sizeof...(I)>{[](Token& token, StringPool* pool) {
+    ParseLiteral<static_cast<TOKEN_TYPE>(I)>{}(token, pool);
+  }...};
+}
+static constexpr auto literal_parsers =
+  make_literal_parsers(std::make_index_sequence<magic_enum::enum_count<TOKEN_TYPE>()>{});
 
-auto lex_token(std::string_view src, std::size_t line) -> lox::result<Token>
+auto make_token(TOKEN_TYPE type, std::string_view lexeme, std::uint32_t line, StringPool* pool) -> Token
+{
+  Token token{type, lexeme, line};
+  literal_parsers[magic_enum::enum_integer(type)](token, pool);
+  return token;
+}
+
+auto regex_token(std::string_view src, std::uint32_t line, StringPool* pool) -> lox::result<Token>
 {
   // Default to an EOF
-  lox::result<Token> token = Token{TOKEN_TYPE::END, src, line, std::monostate{}};
+  lox::result<Token> token = Token{TOKEN_TYPE::END, src, line};
   // Attempt to match our grammar, find a match if available
   auto const extract_match = [&](auto const& match_group, auto i) {
     // Index zero is a full match, which we are not interested in
-    if (i.value == 0 || !match_group) return;
-    // Build a new token from this match groups token type
-    constexpr auto type = static_cast<TOKEN_TYPE>(i.value - 1);
-    token = Token{type, match_group.to_view(), line, ParseLiteral<type>{}(match_group.to_view())};
+    if constexpr (i.value != 0)
+    {
+      if (!match_group) return;
+      // Build a new token from this match groups token type
+      constexpr auto type = pattern::lexed_types[i.value - 1];
+      auto const lexeme = match_group.to_view();
+      if constexpr (type == TOKEN_TYPE::IDENTIFIER)
+      {
+        token = make_token(classify_identifier(lexeme), lexeme, line, pool);
+      }
+      else
+      {
+        Token lexed{type, lexeme, line};
+        ParseLiteral<type>{}(lexed, pool);
+        token = lexed;
+      }
+    }
   };
   // Helper to apply the matcher to each group, index pair with a fold expression
   auto const fwd = [&](auto&&... ms) { (std::apply(extract_match, ms), ...); };
@@ -158,28 +189,162 @@ auto lex_token(std::string_view src, std::size_t line) -> lox::result<Token>
   return token;
 }
 
-auto lex(std::string_view source) -> lox::result<std::vector<Token>>
+namespace scan
+{
+// Character classes matching the ctre escapes used by the regex patterns
+constexpr auto is_space(char c) -> bool
+{
+  return c == ' ' || c == '\t' || c == '\n' || c == '\v' || c == '\f' || c == '\r';
+}
+constexpr auto is_digit(char c) -> bool { return c >= '0' && c <= '9'; }
+constexpr auto is_alpha(char c) -> bool
+{
+  return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_';
+}
+constexpr auto is_word(char c) -> bool { return is_alpha(c) || is_digit(c); }
+
+// Length of the comment starting at src, or zero if src does not begin a complete comment
+auto comment_length(std::string_view src, std::size_t* newlines) -> std::size_t
+{
+  if (src.size() < 2) return 0;
+  auto const first = src.data() + 2;
+  auto const last = src.data() + src.size();
+  // Line comments run up to, but not including the newline
+  if (src[1] == '/') return simd::find(first, last, '\n').position - src.data();
+  if (src[1] != '*') return 0;
+  // Block comments end at the first "*/", unterminated ones fall back to a SLASH
+  auto const end = simd::find_comment_end(first, last);
+  if (end.position == last) return 0;
+  *newlines = end.newlines;
+  return end.position + 2 - src.data();
+}
+
+auto number_length(std::string_view src) -> std::size_t
+{
+  std::size_t i = 0;
+  while (i < src.size() && is_digit(src[i])) ++i;
+  // The fractional part is optional, but must contain at least one digit
+  if (i + 1 < src.size() && src[i] == '.' && is_digit(src[i + 1]))
+  {
+    for (i += 2; i < src.size() && is_digit(src[i]);) ++i;
+  }
+  return i;
+}
+
+auto error_length(std::string_view src) -> std::size_t
+{
+  std::size_t i = 0;
+  while (i < src.size() && !is_space(src[i])) ++i;
+  return i;
+}
+}  // namespace scan
+
+auto scan_token(std::string_view* source, std::uint32_t* line, StringPool* pool) -> lox::result<Token>
+{
+  auto const last = source->data() + source->size();
+  // Skip to the first character which can begin a token, the regex search does the same
+  auto const skipped = simd::skip_whitespace(source->data(), last);
+  *line += skipped.newlines;
+  if (skipped.position == last)
+  {
+    Token const end{TOKEN_TYPE::END, *source, *line};
+    *source = source->substr(source->size());
+    return end;
+  }
+  auto const src = source->substr(skipped.position - source->data());
+
+  // Only comments and strings may contain newlines
+  std::size_t newlines = 0;
+  auto const emit = [&](TOKEN_TYPE type, std::size_t len) {
+    auto token = make_token(type, src.substr(0, len), *line, pool);
+    *source = src.substr(len);
+    *line += newlines;
+    return token;
+  };
+  // Pick between a one or two character token
+  auto const either = [&](char next, TOKEN_TYPE two, TOKEN_TYPE one) {
+    return src.size() > 1 && src[1] == next ? emit(two, 2) : emit(one, 1);
+  };
+  // Branch on the first character, mirroring the priority of the alternation in pattern::full
+  switch (src[0])
+  {
+  case '(': return emit(TOKEN_TYPE::LEFT_PAREN, 1);
+  case ')': return emit(TOKEN_TYPE::RIGHT_PAREN, 1);
+  case '{': return emit(TOKEN_TYPE::LEFT_BRACE, 1);
+  case '}': return emit(TOKEN_TYPE::RIGHT_BRACE, 1);
+  case '[': return emit(TOKEN_TYPE::LEFT_BRACKET, 1);
+  case ']': return emit(TOKEN_TYPE::RIGHT_BRACKET, 1);
+  case ',': return emit(TOKEN_TYPE::COMMA, 1);
+  case '.': return emit(TOKEN_TYPE::DOT, 1);
+  case '-': return emit(TOKEN_TYPE::MINUS, 1);
+  case '+': return emit(TOKEN_TYPE::PLUS, 1);
+  case ';': return emit(TOKEN_TYPE::SEMICOLON, 1);
+  case '*': return emit(TOKEN_TYPE::STAR, 1);
+  case '?': return emit(TOKEN_TYPE::QUESTION, 1);
+  case ':': return emit(TOKEN_TYPE::COLON, 1);
+  case '!': return either('=', TOKEN_TYPE::BANG_EQUAL, TOKEN_TYPE::BANG);
+  case '=': return either('=', TOKEN_TYPE::EQUAL, TOKEN_TYPE::ASSIGN);
+  case '>': return either('=', TOKEN_TYPE::GREATER_EQUAL, TOKEN_TYPE::GREATER);
+  case '<': return either('=', TOKEN_TYPE::LESS_EQUAL, TOKEN_TYPE::LESS);
+  case '/':
+  {
+    if (auto const len = scan::comment_length(src, &newlines)) return emit(TOKEN_TYPE::COMMENT, len);
+    return emit(TOKEN_TYPE::SLASH, 1);
+  }
+  case '"':
+  {
+    // Strings may span multiple lines, without a closing quote they are an error
+    if (auto const end = simd::find(src.data() + 1, last, '"'); end.position != last)
+    {
+      newlines = end.newlines;
+      return emit(TOKEN_TYPE::STRING, end.position + 1 - src.data());
+    }
+    return emit(TOKEN_TYPE::ERROR, scan::error_length(src));
+  }
+  default: break;
+  }
+  if (scan::is_digit(src[0])) return emit(TOKEN_TYPE::NUMBER, scan::number_length(src));
+  if (scan::is_alpha(src[0]))
+  {
+    auto const len = std::find_if_not(src.begin() + 1, src.end(), scan::is_word) - src.begin();
+    return emit(classify_identifier(src.substr(0, len)), len);
+  }
+  // Anything else is consumed up to the next whitespace
+  return emit(TOKEN_TYPE::ERROR, scan::error_length(src));
+}
+
+auto lex_token(std::string_view* source, std::uint32_t* line, StringPool* pool, LEX_BACKEND backend)
+  -> lox::result<Token>
+{
+  if (backend == LEX_BACKEND::SCANNER) return scan_token(source, line, pool);
+
+  auto lexed = regex_token(*source, *line, pool);
+  if (!lexed) return lexed;
+  // The search skips whitespace implicitly, so count the lines it passed over afterwards. An END
+  // token is all whitespace, and belongs to the last line.
+  auto const first = source->data();
+  auto const lexeme_end = lexed->lexeme.data() + lexed->lexeme.size();
+  auto const start = lexed->type == TOKEN_TYPE::END ? lexeme_end : lexed->lexeme.data();
+  lexed->line = *line + simd::count_newlines(first, start);
+  *line = lexed->line + simd::count_newlines(start, lexeme_end);
+  *source = source->substr(lexeme_end - first);
+  return lexed;
+}
+
+auto lex(std::string_view source, StringPool* pool, LEX_BACKEND backend) -> lox::result<std::vector<Token>>
 {
   // Build this token list
   std::vector<Token> tokens;
   // Keep track of the line we're processing
-  std::size_t line = 0;
+  std::uint32_t line = 1;
   // Consume until we're out of input characters
   while (source.size())
   {
-    // Try to lex the next token
-    if (auto lexed = lex_token(source, line); lexed.has_value())
-    {
-      // Advance past the source for this lexeme
-      source = source.substr(&(*lexed).lexeme.back() + 1 - source.data());
-      line = (*lexed).line;
-      // Add the token to our stream
-      tokens.emplace_back(std::move(*lexed));
-    }
-    else
-    {
-      return lox::error(lexed.error());
-    }
+    // Lex the next token, which advances the source and line past it
+    auto lexed = lex_token(&source, &line, pool, backend);
+    if (!lexed) return lox::error(lexed.error());
+    // Add the token to our stream
+    tokens.emplace_back(std::move(*lexed));
   }
   return tokens;
 }
@@ -0,0 +1,199 @@
+#include "lox/lex.hpp"
+
+#include <algorithm>
+#include <thread>
+
+#include "lox/simd.hpp"
+
+namespace lox
+{
+namespace
+{
+// Chunks smaller than this aren't worth a thread
+constexpr std::size_t min_chunk_size = 1 << 16;
+
+// Tokens lexed speculatively from the start of a chunk, which may not be the state the sequential
+// lexer would be in at that point
+struct Chunk
+{
+  // First byte of the chunk, always the start of a line
+  char const* m_first;
+  // First byte of the next chunk
+  char const* m_last;
+  std::vector<Token> m_tokens;
+  // Chunks other than the first intern into their own pool, to be remapped once merged
+  StringPool m_local_pool;
+  StringPool* m_pool;
+  // Line after the final token, relative to the start of the chunk
+  std::uint32_t m_end_line = 0;
+  // Newlines in [m_first, m_last)
+  std::size_t m_newlines = 0;
+  // Lexing stopped at an error before reaching the end of the chunk
+  bool m_failed = false;
+
+  // After merging, the tokens in m_tokens which appear in the output, and the line their lines are
+  // relative to
+  std::size_t m_accepted = 0;
+  std::uint32_t m_base_line = 0;
+  // Maps symbols in m_local_pool to the output pool, when m_pool is the local pool
+  std::vector<Symbol> m_remap;
+  // Where in the output the accepted tokens are copied to
+  std::size_t m_offset = 0;
+};
+
+constexpr Symbol unmapped = ~Symbol{0};
+
+// Run f(i) for each i in [0, count), using a thread per index
+template <typename F>
+auto parallel_for(std::size_t count, F&& f) -> void
+{
+  std::vector<std::thread> threads;
+  threads.reserve(count);
+  for (std::size_t i = 1; i < count; ++i) threads.emplace_back(f, i);
+  if (count) f(0);
+  for (auto& thread : threads) thread.join();
+}
+
+// Whether a token carries a symbol in its pool
+auto has_symbol(Token const& token) -> bool
+{
+  return token.type == TOKEN_TYPE::IDENTIFIER || token.type == TOKEN_TYPE::STRING;
+}
+
+auto end_of(Token const& token) -> char const*
+{
+  return token.lexeme.data() + token.lexeme.size();
+}
+
+// Lex from first until a token ends at or beyond stop. Tokens may run past the end of the chunk.
+auto lex_from(Chunk* chunk, char const* first, char const* stop, char const* last, LEX_BACKEND backend)
+  -> void
+{
+  std::string_view source{first, static_cast<std::size_t>(last - first)};
+  while (source.size() && source.data() < stop)
+  {
+    auto lexed = lex_token(&source, &chunk->m_end_line, chunk->m_pool, backend);
+    if (!lexed)
+    {
+      chunk->m_failed = true;
+      return;
+    }
+    chunk->m_tokens.push_back(*lexed);
+  }
+}
+}  // namespace
+
+auto lex_parallel(std::string_view source, StringPool* pool, std::size_t threads, LEX_BACKEND backend)
+  -> lox::result<std::vector<Token>>
+{
+  auto const count = std::min(threads, source.size() / min_chunk_size);
+  if (count <= 1) return lex(source, pool, backend);
+
+  auto const last = source.data() + source.size();
+  // Split just after the first newline following each even division of the source
+  std::vector<Chunk> chunks(count);
+  char const* first = source.data();
+  for (std::size_t i = 0; i < count; ++i)
+  {
+    auto& chunk = chunks[i];
+    chunk.m_first = first;
+    auto split = source.data() + source.size() * (i + 1) / count;
+    split = i + 1 == count ? last : std::max(split, first);
+    auto const newline = simd::find(split, last, '\n').position;
+    chunk.m_last = newline == last ? last : newline + 1;
+    // The first chunk starts where the sequential lexer does, so can intern straight into the output
+    chunk.m_pool = i == 0 ? pool : &chunk.m_local_pool;
+    first = chunk.m_last;
+  }
+  // Splitting on newlines can leave empty chunks at the end of the source
+  while (chunks.back().m_first == last) chunks.pop_back();
+
+  parallel_for(chunks.size(), [&](std::size_t i) {
+    auto& chunk = chunks[i];
+    chunk.m_newlines = simd::count_newlines(chunk.m_first, chunk.m_last);
+    lex_from(&chunk, chunk.m_first, chunk.m_last, last, backend);
+  });
+
+  // Walk the chunks in order, tracking where the sequential lexer would be. Each chunk's tokens
+  // become valid from the first token which ends where the previous chunk's last token did, as
+  // lexing from the same position always produces the same tokens. Tokens which crossed a chunk
+  // boundary, such as block comments and strings, leave the next chunk out of step, in which case
+  // it is re-lexed from the true position. Symbols are remapped in token order, so that they are
+  // numbered exactly as lex() would number them.
+  char const* position = source.data();
+  std::uint32_t line = 1;
+  std::uint32_t chunk_line = 1;
+  std::size_t total = 0;
+  for (auto& chunk : chunks)
+  {
+    chunk.m_base_line = chunk_line;
+    chunk_line += static_cast<std::uint32_t>(chunk.m_newlines);
+
+    auto& tokens = chunk.m_tokens;
+    std::size_t start = tokens.size();
+    if (position == chunk.m_first) start = 0;
+    // The previous chunk may have consumed this one entirely
+    else if (position >= chunk.m_last) chunk.m_failed = false;
+    else
+    {
+      auto const synced = std::lower_bound(
+        tokens.begin(), tokens.end(), position, [](auto const& t, auto p) { return end_of(t) < p; });
+      if (synced != tokens.end() && end_of(*synced) == position) start = synced - tokens.begin() + 1;
+      else
+      {
+        // Out of step, so lex this chunk again from the true position with the true line
+        tokens.clear();
+        chunk.m_end_line = line;
+        chunk.m_base_line = 0;
+        chunk.m_failed = false;
+        chunk.m_pool = pool;
+        lex_from(&chunk, position, chunk.m_last, last, backend);
+        start = 0;
+      }
+    }
+    // Errors can only be reported with the correct line by the sequential lexer
+    if (chunk.m_failed)
+    {
+      StringPool discard;
+      std::uint32_t error_line = line;
+      std::string_view rest{position, static_cast<std::size_t>(last - position)};
+      while (rest.size())
+      {
+        auto lexed = lex_token(&rest, &error_line, &discard, backend);
+        if (!lexed) return lox::error(lexed.error());
+      }
+    }
+
+    chunk.m_accepted = start;
+    chunk.m_offset = total;
+    total += tokens.size() - start;
+    if (start == tokens.size()) continue;
+    position = end_of(tokens.back());
+    line = chunk.m_base_line + chunk.m_end_line;
+
+    if (chunk.m_pool == pool) continue;
+    chunk.m_remap.assign(chunk.m_pool->size(), unmapped);
+    for (auto token = tokens.begin() + start; token != tokens.end(); ++token)
+    {
+      if (!has_symbol(*token)) continue;
+      auto& mapped = chunk.m_remap[token->symbol];
+      if (mapped == unmapped) mapped = pool->intern((*chunk.m_pool)[token->symbol]);
+    }
+  }
+
+  // Copy the accepted tokens into place, fixing up their lines and symbols
+  std::vector<Token> result(total, Token{TOKEN_TYPE::END, {}, 0});
+  parallel_for(chunks.size(), [&](std::size_t i) {
+    auto const& chunk = chunks[i];
+    auto out = result.begin() + chunk.m_offset;
+    for (auto token = chunk.m_tokens.begin() + chunk.m_accepted; token != chunk.m_tokens.end(); ++token)
+    {
+      auto fixed = *token;
+      fixed.line += chunk.m_base_line;
+      if (!chunk.m_remap.empty() && has_symbol(fixed)) fixed.symbol = chunk.m_remap[fixed.symbol];
+      *out++ = fixed;
+    }
+  });
+  return result;
+}
+}  // namespace lox
@@ -0,0 +1,102 @@
+#include "lox/memory_stats.hpp"
+
+#include <fmt/format.h>
+
+#include <algorithm>
+
+#include <magic_enum/magic_enum.hpp>
+
+#include "lox/output.hpp"
+#include "lox/token.hpp"
+#include "lox/token_stream.hpp"
+
+namespace lox
+{
+namespace
+{
+template <typename T>
+auto find(std::vector<std::pair<std::string_view, T>>* entries, std::string_view name) -> T&
+{
+  auto const found =
+    std::find_if(entries->begin(), entries->end(), [&](auto const& e) { return e.first == name; });
+  if (found != entries->end()) return found->second;
+  return entries->emplace_back(name, T{}).second;
+}
+
+auto readable(double bytes) -> std::string
+{
+  static constexpr std::string_view units[] = {"B", "KiB", "MiB", "GiB"};
+  std::size_t unit = 0;
+  for (; bytes >= 1024 && unit + 1 < std::size(units); ++unit) bytes /= 1024;
+  return unit ? fmt::format("{:.1f} {}", bytes, units[unit]) : fmt::format("{} {}", bytes, units[unit]);
+}
+}  // namespace
+
+auto MemoryStats::counter(std::string_view name, double value) -> void { find(&m_counters, name) += value; }
+
+auto MemoryStats::program(Program const& program) -> void
+{
+  auto const counts = count_nodes(program);
+  for (std::size_t i = 0; i < counts.size(); ++i) m_nodes[i] += counts[i];
+  m_arena_bytes += program.m_arena.m_reserved;
+}
+
+auto MemoryStats::lexed(TokenStream const& tokens) -> void
+{
+  record("lex", tokens.m_lex_allocated);
+  counter("tokens", tokens.m_tokens);
+  m_peak_tokens = std::max(m_peak_tokens, tokens.m_peak_buffered);
+}
+
+auto MemoryStats::record(std::string_view name, AllocationStats allocated) -> void
+{
+  auto& phase = find(&m_phases, name);
+  ++phase.m_spans;
+  phase.m_allocated = phase.m_allocated + allocated;
+}
+
+auto MemoryStats::report(Environment const& environment) const -> void
+{
+  lox::print("Allocations by phase, lexing is done during the parse:\n");
+  lox::print("  {:<12} {:>8} {:>12} {:>12}\n", "", "spans", "allocations", "bytes");
+  for (auto const& [name, phase] : m_phases)
+  {
+    lox::print("  {:<12} {:>8} {:>12} {:>12}\n",
+               name,
+               phase.m_spans,
+               phase.m_allocated.m_count,
+               readable(phase.m_allocated.m_bytes));
+  }
+  for (auto const& [name, value] : m_counters) lox::print("{}: {}\n", name, value);
+  lox::print("Token buffer: at most {} tokens at once, {} of {} byte tokens\n",
+             m_peak_tokens,
+             readable(m_peak_tokens * sizeof(Token)),
+             sizeof(Token));
+
+  std::size_t node_bytes = 0;
+  for (std::size_t i = 0; i < m_nodes.size(); ++i) node_bytes += m_nodes[i] * node_sizes[i];
+  lox::print("Syntax tree: {} nodes in {}, arenas reserved {}\n",
+             total(m_nodes),
+             readable(node_bytes),
+             readable(m_arena_bytes));
+  lox::print("  {:<12} {:>8} {:>8} {:>12}\n", "", "count", "size", "bytes");
+  for (std::size_t i = 0; i < m_nodes.size(); ++i)
+  {
+    if (!m_nodes[i]) continue;
+    lox::print("  {:<12} {:>8} {:>8} {:>12}\n",
+               magic_enum::enum_name(static_cast<NODE_KIND>(i)),
+               m_nodes[i],
+               node_sizes[i],
+               readable(m_nodes[i] * node_sizes[i]));
+  }
+
+  auto const slots = environment.m_slots.capacity() * sizeof(Environment::Value);
+  auto const frames = environment.m_frames.capacity() * sizeof(std::size_t);
+  lox::print("Environment: {} slots in use, {} reserved, {} frames reserved, {}\n",
+             environment.m_slots.size(),
+             environment.m_slots.capacity(),
+             environment.m_frames.capacity(),
+             readable(slots + frames));
+  lox::print("Peak resident: {}\n", readable(peak_resident_bytes()));
+}
+}  // namespace lox
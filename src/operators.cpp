@@ -0,0 +1,151 @@
+#include "lox/operators.hpp"
+
+#include <array>
+#include <functional>
+#include <magic_enum/magic_enum.hpp>
+
+namespace lox
+{
+namespace
+{
+// Applies a binary operator to operands of one particular pair of types
+using BinaryHandler = auto (*)(TOKEN_TYPE op, Value const& lhs, Value const& rhs) -> result<Value>;
+
+constexpr auto type_count = magic_enum::enum_count<VALUE_TYPE>();
+
+auto mismatched_types(TOKEN_TYPE op, Value const&, Value const&) -> result<Value>
+{
+  return lox::operator_error(ERROR_CODE::MISMATCHED_TYPES, magic_enum::enum_name(op));
+}
+
+auto expected_numbers(TOKEN_TYPE op, Value const&, Value const&) -> result<Value>
+{
+  return lox::operator_error(ERROR_CODE::EXPECTED_NUMBERS, magic_enum::enum_name(op));
+}
+
+auto unhandled(TOKEN_TYPE op, Value const&, Value const&) -> result<Value>
+{
+  return lox::operator_error(ERROR_CODE::UNHANDLED_BINARY, magic_enum::enum_name(op));
+}
+
+template <typename Op>
+auto arithmetic(TOKEN_TYPE, Value const& lhs, Value const& rhs) -> result<Value>
+{
+  return Op{}(lhs.as_number(), rhs.as_number());
+}
+
+// Any value followed by a string, or a string followed by a number, concatenates
+auto concatenate_strings(TOKEN_TYPE, Value const& lhs, Value const& rhs) -> result<Value>
+{
+  if (!lhs.is_string()) return concatenate(Value{to_string(lhs)}, rhs);
+  if (!rhs.is_string()) return concatenate(lhs, Value{to_string(rhs)});
+  return concatenate(lhs, rhs);
+}
+
+// Division by zero is reported ahead of any type error
+auto divide(TOKEN_TYPE op, Value const& lhs, Value const& rhs) -> result<Value>
+{
+  if (rhs.as_number() == 0.f)
+  {
+    return lox::operator_error(ERROR_CODE::DIVISION_BY_ZERO, magic_enum::enum_name(op));
+  }
+  if (!lhs.is_number()) return expected_numbers(op, lhs, rhs);
+  return lhs.as_number() / rhs.as_number();
+}
+
+template <typename Op>
+auto compare(TOKEN_TYPE, Value const& lhs, Value const& rhs) -> result<Value>
+{
+  return Op{}(lhs, rhs);
+}
+
+auto comma(TOKEN_TYPE, Value const&, Value const& rhs) -> result<Value> { return rhs; }
+
+using OperatorTable = std::array<std::array<BinaryHandler, type_count>, type_count>;
+
+// Every pair of operand types handled by fn
+constexpr auto fill(BinaryHandler fn) -> OperatorTable
+{
+  OperatorTable table{};
+  for (auto& row : table)
+    for (auto& entry : row) entry = fn;
+  return table;
+}
+
+constexpr auto index(VALUE_TYPE type) -> std::size_t { return static_cast<std::size_t>(type); }
+
+constexpr auto number_operator(BinaryHandler fn) -> OperatorTable
+{
+  auto table = fill(expected_numbers);
+  table[index(VALUE_TYPE::NUMBER)][index(VALUE_TYPE::NUMBER)] = fn;
+  return table;
+}
+
+constexpr auto matched_operator(BinaryHandler fn) -> OperatorTable
+{
+  auto table = fill(mismatched_types);
+  for (std::size_t type = 0; type < type_count; ++type) table[type][type] = fn;
+  return table;
+}
+
+constexpr auto add_operator() -> OperatorTable
+{
+  auto table = fill(mismatched_types);
+  table[index(VALUE_TYPE::NUMBER)][index(VALUE_TYPE::NUMBER)] = arithmetic<std::plus<>>;
+  for (auto& row : table) row[index(VALUE_TYPE::STRING)] = concatenate_strings;
+  table[index(VALUE_TYPE::STRING)][index(VALUE_TYPE::NUMBER)] = concatenate_strings;
+  return table;
+}
+
+constexpr auto divide_operator() -> OperatorTable
+{
+  auto table = fill(expected_numbers);
+  for (auto& row : table) row[index(VALUE_TYPE::NUMBER)] = divide;
+  return table;
+}
+
+// Handlers for every binary operator, indexed by the operator then the types of its operands
+constexpr auto make_binary_table()
+{
+  std::array<OperatorTable, magic_enum::enum_count<TOKEN_TYPE>()> table{};
+  for (auto& op : table) op = fill(unhandled);
+  auto const at = [&](TOKEN_TYPE op) -> OperatorTable& { return table[static_cast<std::size_t>(op)]; };
+  at(TOKEN_TYPE::PLUS) = add_operator();
+  at(TOKEN_TYPE::MINUS) = number_operator(arithmetic<std::minus<>>);
+  at(TOKEN_TYPE::STAR) = number_operator(arithmetic<std::multiplies<>>);
+  at(TOKEN_TYPE::SLASH) = divide_operator();
+  at(TOKEN_TYPE::GREATER) = matched_operator(compare<std::greater<>>);
+  at(TOKEN_TYPE::GREATER_EQUAL) = matched_operator(compare<std::greater_equal<>>);
+  at(TOKEN_TYPE::LESS) = matched_operator(compare<std::less<>>);
+  at(TOKEN_TYPE::LESS_EQUAL) = matched_operator(compare<std::less_equal<>>);
+  at(TOKEN_TYPE::BANG_EQUAL) = fill(compare<std::not_equal_to<>>);
+  at(TOKEN_TYPE::EQUAL) = fill(compare<std::equal_to<>>);
+  at(TOKEN_TYPE::COMMA) = fill(comma);
+  return table;
+}
+
+constexpr auto binary_table = make_binary_table();
+}  // namespace
+
+auto binary(TOKEN_TYPE op, Value const& lhs, Value const& rhs) -> result<Value>
+{
+  return binary_table[static_cast<std::size_t>(op)][index(lhs.type())][index(rhs.type())](op, lhs, rhs);
+}
+
+auto unary(TOKEN_TYPE op, Value const& operand) -> result<Value>
+{
+  switch (op)
+  {
+  case TOKEN_TYPE::MINUS:
+  {
+    if (operand.is_number())
+    {
+      return -operand.as_number();
+    }
+    return lox::operator_error(ERROR_CODE::EXPECTED_NUMBER_OPERAND, magic_enum::enum_name(op));
+  }
+  case TOKEN_TYPE::BANG: return !Truth{}(operand);
+  default: return lox::operator_error(ERROR_CODE::UNHANDLED_UNARY, magic_enum::enum_name(op));
+  }
+}
+}  // namespace lox
@@ -0,0 +1,15 @@
+#include "lox/output.hpp"
+
+namespace
+{
+thread_local std::string* captured = nullptr;
+}  // namespace
+
+namespace lox
+{
+auto captured_output() -> std::string* { return captured; }
+
+OutputCapture::OutputCapture(std::string* buffer) : m_previous(captured) { captured = buffer; }
+
+OutputCapture::~OutputCapture() { captured = m_previous; }
+}  // namespace lox
@@ -0,0 +1,294 @@
+#include "lox/simd.hpp"
+
+#include <algorithm>
+#include <atomic>
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#include <immintrin.h>
+#define LOX_SIMD_X86 1
+#else
+#define LOX_SIMD_X86 0
+#endif
+
+namespace lox
+{
+namespace simd
+{
+namespace
+{
+// Matches the \s character class used by the lexer
+constexpr auto is_space(char c) -> bool
+{
+  return c == ' ' || c == '\t' || c == '\n' || c == '\v' || c == '\f' || c == '\r';
+}
+
+// Scalar kernels, which also finish off the tails of the vectorised ones
+auto skip_whitespace_scalar(char const* first, char const* last, std::size_t newlines = 0) -> Scanned
+{
+  for (; first != last && is_space(*first); ++first) newlines += *first == '\n';
+  return {first, newlines};
+}
+
+auto find_scalar(char const* first, char const* last, char c, std::size_t newlines = 0) -> Scanned
+{
+  for (; first != last && *first != c; ++first) newlines += *first == '\n';
+  return {first, newlines};
+}
+
+auto find_comment_end_scalar(char const* first, char const* last, std::size_t newlines = 0) -> Scanned
+{
+  for (; first != last; ++first)
+  {
+    if (*first == '*' && first + 1 != last && first[1] == '/') return {first, newlines};
+    newlines += *first == '\n';
+  }
+  return {last, newlines};
+}
+
+auto count_newlines_scalar(char const* first, char const* last) -> std::size_t
+{
+  return std::count(first, last, '\n');
+}
+
+#if LOX_SIMD_X86
+// Each kernel loads a block at a time, building a bit mask of the lanes it should stop at. Newlines
+// are counted by a second mask, truncated to the lanes which precede the first stop.
+inline auto lanes_before(std::uint32_t stop) -> std::uint32_t { return (stop & (0u - stop)) - 1u; }
+
+inline auto popcount(std::uint32_t mask) -> std::size_t { return __builtin_popcount(mask); }
+
+// SSE2 is part of the x86-64 baseline, so needs no runtime check
+constexpr std::ptrdiff_t sse2_width = 16;
+constexpr std::uint32_t sse2_full = 0xffff;
+
+inline auto sse2_load(char const* p) -> __m128i
+{
+  return _mm_loadu_si128(reinterpret_cast<__m128i const*>(p));
+}
+
+inline auto sse2_eq(__m128i block, char c) -> std::uint32_t
+{
+  return static_cast<std::uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(block, _mm_set1_epi8(c))));
+}
+
+inline auto sse2_space(__m128i block) -> std::uint32_t
+{
+  // '\t' through '\r' are contiguous, so a single unsigned range check covers them
+  auto const offset = _mm_sub_epi8(block, _mm_set1_epi8('\t'));
+  auto const control = _mm_cmpeq_epi8(_mm_min_epu8(offset, _mm_set1_epi8('\r' - '\t')), offset);
+  auto const space = _mm_cmpeq_epi8(block, _mm_set1_epi8(' '));
+  return static_cast<std::uint32_t>(_mm_movemask_epi8(_mm_or_si128(control, space)));
+}
+
+auto skip_whitespace_sse2(char const* first, char const* last) -> Scanned
+{
+  std::size_t newlines = 0;
+  for (; last - first >= sse2_width; first += sse2_width)
+  {
+    auto const block = sse2_load(first);
+    auto const stop = ~sse2_space(block) & sse2_full;
+    auto const newline = sse2_eq(block, '\n');
+    if (stop) return {first + __builtin_ctz(stop), newlines + popcount(newline & lanes_before(stop))};
+    newlines += popcount(newline);
+  }
+  return skip_whitespace_scalar(first, last, newlines);
+}
+
+auto find_sse2(char const* first, char const* last, char c) -> Scanned
+{
+  std::size_t newlines = 0;
+  for (; last - first >= sse2_width; first += sse2_width)
+  {
+    auto const block = sse2_load(first);
+    auto const stop = sse2_eq(block, c);
+    auto const newline = sse2_eq(block, '\n');
+    if (stop) return {first + __builtin_ctz(stop), newlines + popcount(newline & lanes_before(stop))};
+    newlines += popcount(newline);
+  }
+  return find_scalar(first, last, c, newlines);
+}
+
+auto find_comment_end_sse2(char const* first, char const* last) -> Scanned
+{
+  std::size_t newlines = 0;
+  // The second load reads one character ahead to pair each '*' with a following '/'
+  for (; last - first > sse2_width; first += sse2_width)
+  {
+    auto const block = sse2_load(first);
+    auto const stop = sse2_eq(block, '*') & sse2_eq(sse2_load(first + 1), '/');
+    auto const newline = sse2_eq(block, '\n');
+    if (stop) return {first + __builtin_ctz(stop), newlines + popcount(newline & lanes_before(stop))};
+    newlines += popcount(newline);
+  }
+  return find_comment_end_scalar(first, last, newlines);
+}
+
+auto count_newlines_sse2(char const* first, char const* last) -> std::size_t
+{
+  std::size_t newlines = 0;
+  for (; last - first >= sse2_width; first += sse2_width)
+  {
+    newlines += popcount(sse2_eq(sse2_load(first), '\n'));
+  }
+  return newlines + count_newlines_scalar(first, last);
+}
+
+// AVX2 kernels are compiled for the extension explicitly, and only dispatched to when available
+#define LOX_AVX2 __attribute__((target("avx2")))
+constexpr std::ptrdiff_t avx2_width = 32;
+
+LOX_AVX2 inline auto avx2_load(char const* p) -> __m256i
+{
+  return _mm256_loadu_si256(reinterpret_cast<__m256i const*>(p));
+}
+
+LOX_AVX2 inline auto avx2_eq(__m256i block, char c) -> std::uint32_t
+{
+  return static_cast<std::uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(block, _mm256_set1_epi8(c))));
+}
+
+LOX_AVX2 inline auto avx2_space(__m256i block) -> std::uint32_t
+{
+  auto const offset = _mm256_sub_epi8(block, _mm256_set1_epi8('\t'));
+  auto const control = _mm256_cmpeq_epi8(_mm256_min_epu8(offset, _mm256_set1_epi8('\r' - '\t')), offset);
+  auto const space = _mm256_cmpeq_epi8(block, _mm256_set1_epi8(' '));
+  return static_cast<std::uint32_t>(_mm256_movemask_epi8(_mm256_or_si256(control, space)));
+}
+
+LOX_AVX2 auto skip_whitespace_avx2(char const* first, char const* last) -> Scanned
+{
+  std::size_t newlines = 0;
+  for (; last - first >= avx2_width; first += avx2_width)
+  {
+    auto const block = avx2_load(first);
+    auto const stop = ~avx2_space(block);
+    auto const newline = avx2_eq(block, '\n');
+    if (stop) return {first + __builtin_ctz(stop), newlines + popcount(newline & lanes_before(stop))};
+    newlines += popcount(newline);
+  }
+  return skip_whitespace_scalar(first, last, newlines);
+}
+
+LOX_AVX2 auto find_avx2(char const* first, char const* last, char c) -> Scanned
+{
+  std::size_t newlines = 0;
+  for (; last - first >= avx2_width; first += avx2_width)
+  {
+    auto const block = avx2_load(first);
+    auto const stop = avx2_eq(block, c);
+    auto const newline = avx2_eq(block, '\n');
+    if (stop) return {first + __builtin_ctz(stop), newlines + popcount(newline & lanes_before(stop))};
+    newlines += popcount(newline);
+  }
+  return find_scalar(first, last, c, newlines);
+}
+
+LOX_AVX2 auto find_comment_end_avx2(char const* first, char const* last) -> Scanned
+{
+  std::size_t newlines = 0;
+  for (; last - first > avx2_width; first += avx2_width)
+  {
+    auto const block = avx2_load(first);
+    auto const stop = avx2_eq(block, '*') & avx2_eq(avx2_load(first + 1), '/');
+    auto const newline = avx2_eq(block, '\n');
+    if (stop) return {first + __builtin_ctz(stop), newlines + popcount(newline & lanes_before(stop))};
+    newlines += popcount(newline);
+  }
+  return find_comment_end_scalar(first, last, newlines);
+}
+
+LOX_AVX2 auto count_newlines_avx2(char const* first, char const* last) -> std::size_t
+{
+  std::size_t newlines = 0;
+  for (; last - first >= avx2_width; first += avx2_width)
+  {
+    newlines += popcount(avx2_eq(avx2_load(first), '\n'));
+  }
+  return newlines + count_newlines_scalar(first, last);
+}
+#undef LOX_AVX2
+#endif
+
+struct Kernels
+{
+  ISA isa;
+  auto (*skip_whitespace)(char const*, char const*) -> Scanned;
+  auto (*find)(char const*, char const*, char) -> Scanned;
+  auto (*find_comment_end)(char const*, char const*) -> Scanned;
+  auto (*count_newlines)(char const*, char const*) -> std::size_t;
+};
+
+// The scalar kernels take an extra running newline count, so wrap them to match the others
+constexpr Kernels scalar_kernels{
+  ISA::SCALAR,
+  [](char const* first, char const* last) { return skip_whitespace_scalar(first, last); },
+  [](char const* first, char const* last, char c) { return find_scalar(first, last, c); },
+  [](char const* first, char const* last) { return find_comment_end_scalar(first, last); },
+  count_newlines_scalar,
+};
+#if LOX_SIMD_X86
+constexpr Kernels sse2_kernels{
+  ISA::SSE2, skip_whitespace_sse2, find_sse2, find_comment_end_sse2, count_newlines_sse2};
+constexpr Kernels avx2_kernels{
+  ISA::AVX2, skip_whitespace_avx2, find_avx2, find_comment_end_avx2, count_newlines_avx2};
+#endif
+
+auto kernels_for(ISA isa) -> Kernels const*
+{
+  switch (isa)
+  {
+#if LOX_SIMD_X86
+  case ISA::AVX2: return &avx2_kernels;
+  case ISA::SSE2: return &sse2_kernels;
+#endif
+  default: return &scalar_kernels;
+  }
+}
+
+// The tables are immutable, so threads lexing while set_isa() runs see either the old or the new one
+auto active() -> std::atomic<Kernels const*>&
+{
+  static std::atomic<Kernels const*> kernels{kernels_for(supported_isa())};
+  return kernels;
+}
+
+auto kernels() -> Kernels const& { return *active().load(std::memory_order_acquire); }
+}  // namespace
+
+auto supported_isa() -> ISA
+{
+#if LOX_SIMD_X86
+  static ISA const isa = __builtin_cpu_supports("avx2") ? ISA::AVX2 : ISA::SSE2;
+  return isa;
+#else
+  return ISA::SCALAR;
+#endif
+}
+
+auto active_isa() -> ISA { return kernels().isa; }
+
+auto set_isa(ISA isa) -> ISA
+{
+  auto const* selected = kernels_for(std::min(isa, supported_isa()));
+  active().store(selected, std::memory_order_release);
+  return selected->isa;
+}
+
+auto skip_whitespace(char const* first, char const* last) -> Scanned
+{
+  return kernels().skip_whitespace(first, last);
+}
+
+auto find(char const* first, char const* last, char c) -> Scanned { return kernels().find(first, last, c); }
+
+auto find_comment_end(char const* first, char const* last) -> Scanned
+{
+  return kernels().find_comment_end(first, last);
+}
+
+auto count_newlines(char const* first, char const* last) -> std::size_t
+{
+  return kernels().count_newlines(first, last);
+}
+}  // namespace simd
+}  // namespace lox
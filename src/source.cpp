@@ -0,0 +1,94 @@
+#include "lox/source.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <array>
+#include <cerrno>
+#include <utility>
+
+namespace lox
+{
+Source::Source(Source&& other) noexcept
+  : m_mapping(std::exchange(other.m_mapping, nullptr))
+  , m_size(std::exchange(other.m_size, 0))
+  , m_buffer(std::move(other.m_buffer))
+{
+}
+
+auto Source::operator=(Source&& other) noexcept -> Source&
+{
+  std::swap(m_mapping, other.m_mapping);
+  std::swap(m_size, other.m_size);
+  std::swap(m_buffer, other.m_buffer);
+  return *this;
+}
+
+Source::~Source()
+{
+  if (m_mapping) ::munmap(const_cast<char*>(m_mapping), m_size);
+}
+
+namespace
+{
+// Read everything the descriptor has to offer, used for pipes and anything else we can't map
+auto read_all(int fd, std::size_t size_hint) -> result<std::string>
+{
+  std::string buffer;
+  buffer.reserve(size_hint);
+  std::array<char, 1 << 16> chunk;
+  while (true)
+  {
+    auto const count = ::read(fd, chunk.data(), chunk.size());
+    if (count == 0) return buffer;
+    if (count > 0)
+    {
+      buffer.append(chunk.data(), count);
+    }
+    else if (errno != EINTR)
+    {
+      using namespace std::string_literals;
+      return lox::error("Failed to read file."s, 0ul);
+    }
+  }
+}
+}  // namespace
+
+auto load_source(std::filesystem::path const& path) -> result<Source>
+{
+  using namespace std::string_literals;
+  int const fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd == -1) return lox::error("Failed to open file."s, 0ul);
+
+  Source source;
+  struct stat info;
+  bool const regular = ::fstat(fd, &info) == 0 && S_ISREG(info.st_mode);
+  if (regular && info.st_size > 0)
+  {
+    auto const size = static_cast<std::size_t>(info.st_size);
+    if (void* mapping = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0); mapping != MAP_FAILED)
+    {
+      // The lexer makes a single forward pass over the mapping
+      ::madvise(mapping, size, MADV_SEQUENTIAL);
+      source.m_mapping = static_cast<char const*>(mapping);
+      source.m_size = size;
+    }
+  }
+  // Pipes, devices and anything which failed to map are read the slow way. So are regular files of
+  // size zero, which may be empty or, like /proc and sysfs files, generate their contents on read.
+  if (!source.m_mapping)
+  {
+    auto contents = read_all(fd, regular ? info.st_size : 0);
+    if (!contents)
+    {
+      ::close(fd);
+      return lox::error(contents.error());
+    }
+    source.m_buffer = std::move(*contents);
+  }
+  ::close(fd);
+  return source;
+}
+}  // namespace lox
@@ -0,0 +1,29 @@
+#include "lox/string_pool.hpp"
+
+#include <algorithm>
+
+namespace lox
+{
+auto StringPool::intern(std::string_view str) -> Symbol
+{
+  if (auto found = m_lookup.find(str); found != m_lookup.end()) return found->second;
+
+  // Copy into the newest block, starting another if this string won't fit
+  if (str.size() > m_remaining)
+  {
+    auto const size = std::max(block_size, str.size());
+    m_blocks.emplace_back(new char[size]);
+    m_next = m_blocks.back().get();
+    m_remaining = size;
+  }
+  std::string_view const stored{m_next, str.size()};
+  std::copy(str.begin(), str.end(), m_next);
+  m_next += str.size();
+  m_remaining -= str.size();
+
+  auto const symbol = static_cast<Symbol>(m_strings.size());
+  m_strings.push_back(stored);
+  m_lookup.emplace(stored, symbol);
+  return symbol;
+}
+}  // namespace lox
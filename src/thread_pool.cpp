@@ -0,0 +1,107 @@
+#include "lox/thread_pool.hpp"
+
+#include <algorithm>
+#include <utility>
+
+namespace
+{
+// The pool whose worker is running on this thread, if any, and which worker it is
+thread_local lox::ThreadPool const* current_pool = nullptr;
+thread_local std::size_t current_worker = 0;
+}  // namespace
+
+namespace lox
+{
+ThreadPool::ThreadPool(std::size_t threads)
+{
+  threads = std::max<std::size_t>(threads, 1);
+  m_queues.reserve(threads);
+  for (std::size_t i = 0; i < threads; ++i) m_queues.push_back(std::make_unique<Queue>());
+  // Every queue exists before any worker can steal from it
+  m_workers.reserve(threads);
+  for (std::size_t i = 0; i < threads; ++i) m_workers.emplace_back([this, i] { work(i); });
+}
+
+ThreadPool::~ThreadPool()
+{
+  wait();
+  {
+    std::lock_guard lock{m_mutex};
+    m_stopping = true;
+  }
+  m_queued_changed.notify_all();
+  for (auto& worker : m_workers) worker.join();
+}
+
+auto ThreadPool::submit(Task task) -> void
+{
+  std::size_t index = 0;
+  {
+    std::lock_guard lock{m_mutex};
+    // Pending before it is queued, so a worker which takes it straight away can't finish it first
+    ++m_pending;
+    index = current_pool == this ? current_worker : m_next++ % m_queues.size();
+  }
+  {
+    // Queued under the queue's lock, as take() removes it, so the count matches the queues whenever a
+    // worker reads it and a woken worker always finds a task
+    auto& queue = *m_queues[index];
+    std::lock_guard lock{queue.m_mutex};
+    queue.m_tasks.push_back(std::move(task));
+    std::lock_guard count{m_mutex};
+    ++m_queued;
+  }
+  m_queued_changed.notify_one();
+}
+
+auto ThreadPool::wait() -> void
+{
+  std::unique_lock lock{m_mutex};
+  m_idle.wait(lock, [&] { return m_pending == 0; });
+}
+
+auto ThreadPool::work(std::size_t index) -> void
+{
+  current_pool = this;
+  current_worker = index;
+  while (true)
+  {
+    if (auto task = take(index))
+    {
+      (*task)();
+      std::lock_guard lock{m_mutex};
+      if (--m_pending == 0) m_idle.notify_all();
+      continue;
+    }
+    std::unique_lock lock{m_mutex};
+    m_queued_changed.wait(lock, [&] { return m_queued || m_stopping; });
+    if (m_stopping && !m_queued) return;
+  }
+}
+
+auto ThreadPool::take(std::size_t index) -> std::optional<Task>
+{
+  for (std::size_t i = 0; i < m_queues.size(); ++i)
+  {
+    auto& queue = *m_queues[(index + i) % m_queues.size()];
+    std::unique_lock lock{queue.m_mutex};
+    if (queue.m_tasks.empty()) continue;
+    std::optional<Task> task;
+    if (i == 0)
+    {
+      task = std::move(queue.m_tasks.front());
+      queue.m_tasks.pop_front();
+    }
+    else
+    {
+      // Stealing from the other end leaves the owner the tasks it would run next
+      task = std::move(queue.m_tasks.back());
+      queue.m_tasks.pop_back();
+    }
+    std::lock_guard count{m_mutex};
+    --m_queued;
+    return task;
+  }
+  return std::nullopt;
+}
+}  // namespace lox
@@ -0,0 +1,64 @@
+#include "lox/token_stream.hpp"
+
+#include <algorithm>
+
+namespace lox
+{
+TokenStream::TokenStream(std::string_view source, StringPool* pool, LEX_BACKEND backend)
+  : m_source(source), m_pool(pool), m_backend(backend)
+{
+}
+
+auto TokenStream::at(std::size_t position) -> Token const*
+{
+  // Lex until the requested token is buffered, or we run out of input
+  while (position >= m_offset + m_buffer.size())
+  {
+    if (m_source.empty() || m_error) return nullptr;
+    auto lexed = lex();
+    if (!lexed)
+    {
+      m_error = lexed.error();
+      return nullptr;
+    }
+    // Trivia never reaches the parser
+    if ((*lexed).type == TOKEN_TYPE::COMMENT) continue;
+    m_buffer.emplace_back(std::move(*lexed));
+    ++m_tokens;
+    m_peak_buffered = std::max(m_peak_buffered, m_buffer.size());
+  }
+  return position < m_offset ? nullptr : &m_buffer[position - m_offset];
+}
+
+auto TokenStream::lex() -> result<Token>
+{
+  if (!m_measured) return lex_token(&m_source, &m_line, m_pool, m_backend);
+  AllocationScope const allocated;
+  auto const start = clock::now();
+  if (m_lex_start == clock::time_point{}) m_lex_start = start;
+  auto lexed = lex_token(&m_source, &m_line, m_pool, m_backend);
+  m_lex_time += clock::now() - start;
+  m_lex_allocated = m_lex_allocated + allocated.stats();
+  return lexed;
+}
+
+auto TokenStream::release(std::size_t position) -> void
+{
+  // Keep a single token of history
+  while (m_offset + 1 < position && !m_buffer.empty())
+  {
+    m_buffer.pop_front();
+    ++m_offset;
+  }
+}
+
+auto TokenCursor::previous() const -> Token
+{
+  if (m_position > 0)
+  {
+    if (auto const token = m_stream->at(m_position - 1)) return *token;
+  }
+  if (auto const token = m_stream->at(m_position)) return *token;
+  return Token{TOKEN_TYPE::END, {}, m_stream->m_line};
+}
+}  // namespace lox
@@ -0,0 +1,91 @@
+#include "lox/trace.hpp"
+
+#include "lox/ast/count.hpp"
+#include "lox/token_stream.hpp"
+
+#include <fmt/format.h>
+
+#include <fstream>
+#include <iterator>
+#include <string>
+
+namespace lox
+{
+namespace
+{
+auto microseconds(Tracer::clock::duration time) -> double
+{
+  return std::chrono::duration<double, std::micro>(time).count();
+}
+
+// Names are literals chosen by the caller, but are escaped so that the file is always valid JSON
+auto escaped(std::string_view name) -> std::string
+{
+  std::string out;
+  out.reserve(name.size());
+  for (auto const c : name)
+  {
+    if (c == '"' || c == '\\') out += '\\';
+    if (static_cast<unsigned char>(c) < 0x20)
+    {
+      out += fmt::format("\\u{:04x}", static_cast<int>(c));
+      continue;
+    }
+    out += c;
+  }
+  return out;
+}
+}  // namespace
+
+auto Tracer::program(Program const& program) -> void
+{
+  counter("nodes", total(count_nodes(program)));
+}
+
+auto Tracer::lexed(TokenStream const& tokens) -> void
+{
+  // Lexing is spread through the parse, so its total is shown starting where the first token was lexed
+  if (tokens.m_lex_start != clock::time_point{})
+  {
+    m_events.push_back({'X', "lex", 0, tokens.m_lex_start, tokens.m_lex_time, 0});
+  }
+  counter("tokens", tokens.m_tokens);
+}
+
+auto Tracer::write(std::filesystem::path const& path) const -> result<void>
+{
+  std::string json = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+  auto out = std::back_inserter(json);
+  for (std::size_t i = 0; i < m_events.size(); ++i)
+  {
+    auto const& event = m_events[i];
+    auto const name = escaped(event.m_name);
+    auto const ts = microseconds(event.m_start - m_origin);
+    json += i ? ",\n" : "\n";
+    if (event.m_phase == 'C')
+    {
+      fmt::format_to(out,
+                     "{{\"name\":\"{0}\",\"ph\":\"C\",\"pid\":1,\"tid\":1,\"ts\":{1:.3f},"
+                     "\"args\":{{\"{0}\":{2}}}}}",
+                     name,
+                     ts,
+                     event.m_value);
+      continue;
+    }
+    fmt::format_to(out,
+                   "{{\"name\":\"{}\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":{:.3f},\"dur\":{:.3f}",
+                   name,
+                   ts,
+                   microseconds(event.m_duration));
+    if (event.m_line) fmt::format_to(out, ",\"args\":{{\"line\":{}}}", event.m_line);
+    json += '}';
+  }
+  json += "\n]}\n";
+
+  std::ofstream file{path};
+  if (!file) return lox::error(fmt::format("Could not open '{}' to write the trace.", path.string()), ~0u);
+  file << json;
+  if (!file) return lox::error(fmt::format("Failed to write the trace to '{}'.", path.string()), ~0u);
+  return lox::ok();
+}
+}  // namespace lox
@@ -0,0 +1,142 @@
+#include "lox/value.hpp"
+
+#include <array>
+#include <functional>
+#include <utility>
+#include <vector>
+
+namespace lox
+{
+namespace
+{
+// Concatenations up to this length are copied, as that's cheaper than keeping a rope
+constexpr std::size_t small_string = 64;
+
+auto box(StringObject* object) -> std::uint64_t
+{
+  return Value::quiet_nan | Value::string_tag |
+         static_cast<std::uint64_t>(reinterpret_cast<std::uintptr_t>(object));
+}
+
+// Drop a reference to a string, along with those held by any ropes it was the last reference to.
+// Ropes built up one piece at a time are very deep, so this can't recurse.
+auto release(StringObject* object) -> void
+{
+  if (--object->m_references) return;
+  if (!object->m_left)
+  {
+    delete object;
+    return;
+  }
+  // Ropes waiting to be deleted, which only spill onto the heap when a deep rope dies at once
+  std::array<StringObject*, 32> pending;
+  std::size_t count = 0;
+  std::vector<StringObject*> spilled;
+  pending[count++] = object;
+  while (count || !spilled.empty())
+  {
+    StringObject* next;
+    if (spilled.empty()) next = pending[--count];
+    else
+    {
+      next = spilled.back();
+      spilled.pop_back();
+    }
+    for (auto const half : {next->m_left, next->m_right})
+    {
+      if (!half || --half->m_references) continue;
+      if (!half->m_left) delete half;
+      else if (count < pending.size()) pending[count++] = half;
+      else spilled.push_back(half);
+    }
+    delete next;
+  }
+}
+
+// Apply a comparison with the semantics of the same comparison between variants: values of the
+// same type compare their contents, otherwise their types are compared
+template <typename Compare>
+auto compare(Value const& lhs, Value const& rhs, Compare op) -> bool
+{
+  auto const type = lhs.type();
+  if (type != rhs.type()) return op(type, rhs.type());
+  switch (type)
+  {
+  case VALUE_TYPE::NUMBER: return op(lhs.as_number(), rhs.as_number());
+  case VALUE_TYPE::STRING: return op(lhs.as_string(), rhs.as_string());
+  case VALUE_TYPE::BOOL: return op(lhs.as_bool(), rhs.as_bool());
+  // Every nil is equal
+  default: return op(0, 0);
+  }
+}
+}  // namespace
+
+Value::Value(std::string_view v) : Value(std::string{v}) {}
+
+Value::Value(std::string&& v)
+{
+  auto const length = v.size();
+  m_bits = box(new StringObject{1, length, std::move(v)});
+}
+
+auto Value::release() -> void { lox::release(as_object()); }
+
+auto Value::flatten(StringObject* object) -> void
+{
+  std::string flat;
+  flat.reserve(object->m_length);
+  // Walk the leaves left to right, stopping at any halves which have been flattened already
+  std::vector<StringObject const*> pending{object->m_right, object->m_left};
+  while (!pending.empty())
+  {
+    auto const next = pending.back();
+    pending.pop_back();
+    if (next->m_left)
+    {
+      pending.push_back(next->m_right);
+      pending.push_back(next->m_left);
+    }
+    else flat += next->m_string;
+  }
+  object->m_string = std::move(flat);
+  lox::release(std::exchange(object->m_left, nullptr));
+  lox::release(std::exchange(object->m_right, nullptr));
+}
+
+auto concatenate(Value const& lhs, Value const& rhs) -> Value
+{
+  auto const left = lhs.as_object();
+  auto const right = rhs.as_object();
+  auto const length = left->m_length + right->m_length;
+  if (length <= small_string) return Value{lhs.as_string() + rhs.as_string()};
+  ++left->m_references;
+  ++right->m_references;
+  Value joined;
+  joined.m_bits = box(new StringObject{1, length, {}, left, right});
+  return joined;
+}
+
+auto operator==(Value const& lhs, Value const& rhs) -> bool { return compare(lhs, rhs, std::equal_to<>{}); }
+auto operator!=(Value const& lhs, Value const& rhs) -> bool
+{
+  return compare(lhs, rhs, std::not_equal_to<>{});
+}
+auto operator<(Value const& lhs, Value const& rhs) -> bool { return compare(lhs, rhs, std::less<>{}); }
+auto operator<=(Value const& lhs, Value const& rhs) -> bool { return compare(lhs, rhs, std::less_equal<>{}); }
+auto operator>(Value const& lhs, Value const& rhs) -> bool { return compare(lhs, rhs, std::greater<>{}); }
+auto operator>=(Value const& lhs, Value const& rhs) -> bool
+{
+  return compare(lhs, rhs, std::greater_equal<>{});
+}
+
+auto to_string(Value const& value) -> std::string
+{
+  switch (value.type())
+  {
+  case VALUE_TYPE::NUMBER: return std::to_string(value.as_number());
+  case VALUE_TYPE::STRING: return value.as_string();
+  case VALUE_TYPE::BOOL: return value.as_bool() ? "true" : "false";
+  default: return "nil";
+  }
+}
+}  // namespace lox
@@ -0,0 +1,176 @@
+#include "lox/vm/compiler.hpp"
+
+#include <string_view>
+#include <unordered_map>
+
+namespace lox
+{
+namespace
+{
+// Emits each visited expression so that its value ends up in the accumulator, just as the tree
+// interpreter leaves it in result
+struct Compiler final : public AstVisitor
+{
+  virtual auto visit(Definition const& expr) -> result<void> override
+  {
+    expr.m_value->accept(*this);
+    emit(OP_CODE::DEFINE, expr.m_slot);
+    return lox::ok();
+  }
+  virtual auto visit(Read const& expr) -> result<void> override
+  {
+    emit(OP_CODE::READ, access(expr.m_name, expr.m_binding));
+    return lox::ok();
+  }
+  virtual auto visit(Statement const& expr) -> result<void> override
+  {
+    expr.m_expression->accept(*this);
+    emit(OP_CODE::NIL);
+    return lox::ok();
+  }
+  virtual auto visit(Block const& expr) -> result<void> override
+  {
+    emit(OP_CODE::PUSH_SCOPE, expr.m_size);
+    for (auto const& e : expr.m_expressions)
+    {
+      // Errors escaping a declaration skip straight to the next one
+      auto const handler = m_chunk.m_handlers.size();
+      m_chunk.m_handlers.push_back({offset(), 0, m_depth});
+      e->accept(*this);
+      m_chunk.m_handlers[handler].m_end = offset();
+    }
+    emit(OP_CODE::POP_SCOPE);
+    return lox::ok();
+  }
+  virtual auto visit(Print const& expr) -> result<void> override
+  {
+    expr.m_value->accept(*this);
+    emit(OP_CODE::PRINT);
+    return lox::ok();
+  }
+  virtual auto visit(Assign const& expr) -> result<void> override
+  {
+    expr.m_value->accept(*this);
+    emit(OP_CODE::ASSIGN, access(expr.m_name, expr.m_binding));
+    return lox::ok();
+  }
+  virtual auto visit(Ternary const& expr) -> result<void> override
+  {
+    expr.m_cond->accept(*this);
+    auto const to_right = emit(OP_CODE::JUMP_IF_FALSE, 0);
+    expr.m_left->accept(*this);
+    auto const to_end = emit(OP_CODE::JUMP, 0);
+    patch(to_right);
+    expr.m_right->accept(*this);
+    patch(to_end);
+    return lox::ok();
+  }
+  virtual auto visit(Binary const& expr) -> result<void> override
+  {
+    expr.m_left->accept(*this);
+    // The comma operator only needs its left hand side evaluating
+    if (expr.m_op == TOKEN_TYPE::COMMA)
+    {
+      expr.m_right->accept(*this);
+      return lox::ok();
+    }
+    emit(OP_CODE::PUSH);
+    ++m_depth;
+    expr.m_right->accept(*this);
+    --m_depth;
+    emit(binary_op(expr.m_op));
+    return lox::ok();
+  }
+  virtual auto visit(Group const& expr) -> result<void> override { return expr.m_expression->accept(*this); }
+  virtual auto visit(Literal const& expr) -> result<void> override
+  {
+    if (expr.m_literal.is_nil())
+    {
+      emit(OP_CODE::NIL);
+      return lox::ok();
+    }
+    emit(OP_CODE::CONSTANT, static_cast<std::uint32_t>(m_chunk.m_constants.size()));
+    m_chunk.m_constants.push_back(expr.m_literal);
+    return lox::ok();
+  }
+  virtual auto visit(Unary const& expr) -> result<void> override
+  {
+    expr.m_expression->accept(*this);
+    emit(expr.m_op == TOKEN_TYPE::MINUS ? OP_CODE::NEGATE : OP_CODE::NOT);
+    return lox::ok();
+  }
+
+  static auto binary_op(TOKEN_TYPE op) -> OP_CODE
+  {
+    switch (op)
+    {
+    case TOKEN_TYPE::PLUS: return OP_CODE::ADD;
+    case TOKEN_TYPE::MINUS: return OP_CODE::SUBTRACT;
+    case TOKEN_TYPE::STAR: return OP_CODE::MULTIPLY;
+    case TOKEN_TYPE::SLASH: return OP_CODE::DIVIDE;
+    case TOKEN_TYPE::GREATER: return OP_CODE::GREATER;
+    case TOKEN_TYPE::GREATER_EQUAL: return OP_CODE::GREATER_EQUAL;
+    case TOKEN_TYPE::LESS: return OP_CODE::LESS;
+    case TOKEN_TYPE::LESS_EQUAL: return OP_CODE::LESS_EQUAL;
+    case TOKEN_TYPE::BANG_EQUAL: return OP_CODE::NOT_EQUAL;
+    default: return OP_CODE::EQUAL;
+    }
+  }
+
+  // Index of a variable name, each distinct name is stored once
+  auto name(Token const& token) -> std::uint32_t
+  {
+    auto const next = static_cast<std::uint32_t>(m_chunk.m_names.size());
+    auto [it, inserted] = m_names.try_emplace(token.lexeme, next);
+    if (inserted) m_chunk.m_names.emplace_back(token.lexeme);
+    return it->second;
+  }
+
+  // Index of a new access, copying its binding into the chunk
+  auto access(Token const& token, Binding binding) -> std::uint32_t
+  {
+    auto const first = static_cast<std::uint32_t>(m_chunk.m_slots.size());
+    m_chunk.m_slots.insert(m_chunk.m_slots.end(), binding.begin(), binding.end());
+    m_chunk.m_accesses.push_back({name(token), first, static_cast<std::uint32_t>(binding.size())});
+    return static_cast<std::uint32_t>(m_chunk.m_accesses.size() - 1);
+  }
+
+  auto offset() const -> std::uint32_t { return static_cast<std::uint32_t>(m_chunk.m_code.size()); }
+
+  auto emit(OP_CODE op) -> void { m_chunk.m_code.push_back(static_cast<std::uint8_t>(op)); }
+
+  // Emit an instruction with an operand, returning the operand's offset
+  auto emit(OP_CODE op, std::uint32_t operand) -> std::uint32_t
+  {
+    emit(op);
+    auto const at = offset();
+    for (int i = 0; i < 4; ++i) m_chunk.m_code.push_back(static_cast<std::uint8_t>(operand >> (8 * i)));
+    return at;
+  }
+
+  // Point a jump operand at the next instruction
+  auto patch(std::uint32_t at) -> void
+  {
+    auto const target = offset();
+    for (int i = 0; i < 4; ++i) m_chunk.m_code[at + i] = static_cast<std::uint8_t>(target >> (8 * i));
+  }
+
+  Chunk m_chunk;
+  std::unordered_map<std::string_view, std::uint32_t> m_names;
+  // Number of values on the stack at the current instruction
+  std::uint32_t m_depth = 0;
+};
+}  // namespace
+
+auto compile(Program const& program) -> Chunk
+{
+  Compiler compiler;
+  for (auto const& expr : program.m_expressions)
+  {
+    compiler.m_chunk.m_roots.push_back(compiler.offset());
+    expr->accept(compiler);
+    compiler.emit(OP_CODE::RETURN);
+  }
+  return std::move(compiler.m_chunk);
+}
+}  // namespace lox
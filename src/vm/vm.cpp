@@ -0,0 +1,266 @@
+#include "lox/vm/vm.hpp"
+
+#include <fmt/format.h>
+
+#include <iterator>
+#include <magic_enum/magic_enum.hpp>
+
+#include "lox/operators.hpp"
+#include "lox/output.hpp"
+
+// Dispatch through a table of label addresses where the compiler supports it, which gives each
+// instruction its own indirect branch for the predictor to learn. Define as 0 to use a switch.
+#if !defined(LOX_VM_COMPUTED_GOTO)
+#if defined(__GNUC__)
+#define LOX_VM_COMPUTED_GOTO 1
+#else
+#define LOX_VM_COMPUTED_GOTO 0
+#endif
+#endif
+
+namespace lox
+{
+namespace
+{
+auto read_operand(std::uint8_t const* code) -> std::uint32_t
+{
+  return std::uint32_t{code[0]} | std::uint32_t{code[1]} << 8 | std::uint32_t{code[2]} << 16 |
+         std::uint32_t{code[3]} << 24;
+}
+}  // namespace
+
+#if LOX_VM_COMPUTED_GOTO
+// Taking the address of a label is an extension
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpedantic"
+#endif
+auto VM::run(Chunk const& chunk, std::size_t root) -> lox::result<void>
+{
+  auto const code = chunk.m_code.data();
+  auto pc = code + chunk.m_roots[root];
+  // Set by any instruction which fails
+  Error error;
+  stack.clear();
+
+  // Both operands are numbers in the common case, which can skip the generic operators. Returns
+  // false on error.
+  auto const arithmetic = [&](TOKEN_TYPE op, auto&& fast) {
+    auto const& lhs = stack.back();
+    bool ok = true;
+    if (lhs.is_number() && result.is_number())
+    {
+      result = fast(lhs.as_number(), result.as_number());
+    }
+    else if (auto evaluated = binary(op, lhs, result))
+    {
+      result = std::move(*evaluated);
+    }
+    else
+    {
+      error = std::move(evaluated.error());
+      ok = false;
+    }
+    stack.pop_back();
+    return ok;
+  };
+
+#if LOX_VM_COMPUTED_GOTO
+  // Must match the order of OP_CODE
+  static void* const dispatch_table[] = {
+    &&op_CONSTANT,   &&op_NIL,       &&op_READ,          &&op_DEFINE,     &&op_ASSIGN,
+    &&op_PRINT,      &&op_PUSH,      &&op_ADD,           &&op_SUBTRACT,   &&op_MULTIPLY,
+    &&op_DIVIDE,     &&op_GREATER,   &&op_GREATER_EQUAL, &&op_LESS,       &&op_LESS_EQUAL,
+    &&op_NOT_EQUAL,  &&op_EQUAL,     &&op_NEGATE,        &&op_NOT,        &&op_JUMP,
+    &&op_JUMP_IF_FALSE, &&op_PUSH_SCOPE, &&op_POP_SCOPE, &&op_RETURN,
+  };
+  static_assert(std::size(dispatch_table) == magic_enum::enum_count<OP_CODE>());
+#define TARGET(op) op_##op
+#define DISPATCH() goto* dispatch_table[*pc++]
+resume:
+  DISPATCH();
+#else
+#define TARGET(op) case OP_CODE::op
+#define DISPATCH() continue
+resume:
+  for (;;)
+  {
+    switch (static_cast<OP_CODE>(*pc++))
+    {
+#endif
+  TARGET(CONSTANT):
+  {
+    result = chunk.m_constants[read_operand(pc)];
+    pc += 4;
+    DISPATCH();
+  }
+  TARGET(NIL):
+  {
+    result = std::monostate{};
+    DISPATCH();
+  }
+  TARGET(READ):
+  {
+    auto const& access = chunk.m_accesses[read_operand(pc)];
+    auto value = environment.lookup(chunk.binding(access), chunk.m_names[access.m_name]);
+    pc += 4;
+    if (!value)
+    {
+      error = std::move(value.error());
+      goto fail;
+    }
+    result = (*value)->value;
+    DISPATCH();
+  }
+  TARGET(DEFINE):
+  {
+    environment.define(read_operand(pc), Environment::Value{result});
+    pc += 4;
+    DISPATCH();
+  }
+  TARGET(ASSIGN):
+  {
+    auto const& access = chunk.m_accesses[read_operand(pc)];
+    auto assigned =
+      environment.assign(chunk.binding(access), chunk.m_names[access.m_name], Environment::Value{result});
+    pc += 4;
+    if (!assigned)
+    {
+      error = std::move(assigned.error());
+      goto fail;
+    }
+    DISPATCH();
+  }
+  TARGET(PRINT):
+  {
+    lox::print("{}\n", result);
+    result = std::monostate{};
+    DISPATCH();
+  }
+  TARGET(PUSH):
+  {
+    stack.push_back(result);
+    DISPATCH();
+  }
+  TARGET(ADD):
+  {
+    if (!arithmetic(TOKEN_TYPE::PLUS, std::plus<>{})) goto fail;
+    DISPATCH();
+  }
+  TARGET(SUBTRACT):
+  {
+    if (!arithmetic(TOKEN_TYPE::MINUS, std::minus<>{})) goto fail;
+    DISPATCH();
+  }
+  TARGET(MULTIPLY):
+  {
+    if (!arithmetic(TOKEN_TYPE::STAR, std::multiplies<>{})) goto fail;
+    DISPATCH();
+  }
+  TARGET(DIVIDE):
+  {
+    // Division by zero is left to the generic operator to report
+    if (result.is_number() && result.as_number() == 0.f)
+    {
+      error = binary(TOKEN_TYPE::SLASH, stack.back(), result).error();
+      stack.pop_back();
+      goto fail;
+    }
+    else
+    {
+      if (!arithmetic(TOKEN_TYPE::SLASH, std::divides<>{})) goto fail;
+    }
+    DISPATCH();
+  }
+  TARGET(GREATER):
+  {
+    if (!arithmetic(TOKEN_TYPE::GREATER, std::greater<>{})) goto fail;
+    DISPATCH();
+  }
+  TARGET(GREATER_EQUAL):
+  {
+    if (!arithmetic(TOKEN_TYPE::GREATER_EQUAL, std::greater_equal<>{})) goto fail;
+    DISPATCH();
+  }
+  TARGET(LESS):
+  {
+    if (!arithmetic(TOKEN_TYPE::LESS, std::less<>{})) goto fail;
+    DISPATCH();
+  }
+  TARGET(LESS_EQUAL):
+  {
+    if (!arithmetic(TOKEN_TYPE::LESS_EQUAL, std::less_equal<>{})) goto fail;
+    DISPATCH();
+  }
+  TARGET(NOT_EQUAL):
+  {
+    if (!arithmetic(TOKEN_TYPE::BANG_EQUAL, std::not_equal_to<>{})) goto fail;
+    DISPATCH();
+  }
+  TARGET(EQUAL):
+  {
+    if (!arithmetic(TOKEN_TYPE::EQUAL, std::equal_to<>{})) goto fail;
+    DISPATCH();
+  }
+  TARGET(NEGATE):
+  {
+    if (!result.is_number())
+    {
+      error = unary(TOKEN_TYPE::MINUS, result).error();
+      goto fail;
+    }
+    result = -result.as_number();
+    DISPATCH();
+  }
+  TARGET(NOT):
+  {
+    result = !Truth{}(result);
+    DISPATCH();
+  }
+  TARGET(JUMP):
+  {
+    pc = code + read_operand(pc);
+    DISPATCH();
+  }
+  TARGET(JUMP_IF_FALSE):
+  {
+    pc = Truth{}(result) ? pc + 4 : code + read_operand(pc);
+    DISPATCH();
+  }
+  TARGET(PUSH_SCOPE):
+  {
+    environment.push_scope(read_operand(pc));
+    pc += 4;
+    DISPATCH();
+  }
+  TARGET(POP_SCOPE):
+  {
+    environment.pop_scope();
+    DISPATCH();
+  }
+  TARGET(RETURN): return lox::ok();
+#if !LOX_VM_COMPUTED_GOTO
+    }
+  }
+#endif
+#undef TARGET
+#undef DISPATCH
+
+fail:
+  // Resume after the innermost block declaration containing the failed instruction, which is the
+  // last handler to start before it. Errors outside of any block end the declaration.
+  {
+    auto const failed = static_cast<std::uint32_t>(pc - 1 - code);
+    for (auto h = chunk.m_handlers.rbegin(); h != chunk.m_handlers.rend(); ++h)
+    {
+      if (h->m_begin > failed || failed >= h->m_end) continue;
+      stack.resize(h->m_depth);
+      pc = code + h->m_end;
+      goto resume;
+    }
+  }
+  return lox::error(std::move(error));
+}
+#if LOX_VM_COMPUTED_GOTO
+#pragma GCC diagnostic pop
+#endif
+}  // namespace lox
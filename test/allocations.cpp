@@ -0,0 +1,58 @@
+#include <fmt/format.h>
+
+#include <cstdlib>
+#include <string>
+#include <string_view>
+
+#include "lox/allocation.hpp"
+#include "lox/ast/interpreter.hpp"
+#include "lox/ast/parse.hpp"
+#include "lox/ast/resolve.hpp"
+#include "lox/token_stream.hpp"
+
+// Allocation budgets which the tree interpreter must keep. Fails if any is exceeded.
+namespace
+{
+// Run source, then evaluate its last expression over and over, checking that each evaluation
+// allocates exactly expected times. The first evaluation may grow the environment, so isn't counted.
+auto allocates(std::string_view name, std::string const& source, std::size_t expected) -> bool
+{
+  lox::StringPool pool;
+  lox::TokenStream tokens{source, &pool};
+  auto program = lox::parse(tokens);
+  if (!program)
+  {
+    fmt::print("FAIL {}: {}\n", name, program.error().describe());
+    return false;
+  }
+  lox::Resolver{}.resolve(&*program);
+  lox::Interpreter interpreter;
+  for (auto const& root : program->m_expressions) root->accept(interpreter);
+
+  constexpr std::size_t evaluations = 100;
+  auto const& last = *program->m_expressions.back();
+  lox::AllocationScope const scope;
+  for (std::size_t i = 0; i < evaluations; ++i) interpreter.evaluate(last);
+  auto const allocations = scope.stats().m_count;
+  if (allocations == expected * evaluations) return true;
+  fmt::print("FAIL {}: {} allocations per evaluation, expected {}\n",
+             name,
+             static_cast<double>(allocations) / evaluations,
+             expected);
+  return false;
+}
+}  // namespace
+
+auto main() -> int
+{
+  lox::set_counting_allocations(true);
+  bool passed = true;
+  // Three strings too long to be copied, which should allocate only the two joins
+  std::string const text(100, 'x');
+  passed &= allocates("string chain", "var a = \"" + text + "\"; var b = a; var c = a; a + b + c;", 2);
+  // Entering and leaving nested blocks declaring variables, once the environment has grown to fit them
+  passed &= allocates(
+    "nested blocks", "{ var a = 1; { var b = a; var c = b; { var d = c + a; } } { var e = a; } }", 0);
+  if (passed) fmt::print("Every allocation budget was kept.\n");
+  return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,54 @@
+#!/usr/bin/env bash
+# Runs every script on each engine, with and without the optimizer, and checks that the output and
+# exit status match test/expected/<script name>.out exactly. Runtime errors included, every engine
+# must behave as the tree interpreter does.
+#
+# usage: check_engines.sh [--update] <lox binary> <script>...
+#   --update  rewrite the expected output from the tree interpreter instead of checking it
+set -u
+
+update=0
+if [ "${1:-}" = "--update" ]; then
+  update=1
+  shift
+fi
+lox=$1
+shift
+expected_dir=$(dirname "$0")/expected
+
+# Everything a run prints, except the banner naming the script's path and the optimizer's statistics,
+# followed by its exit status
+run() {
+  local script=$1
+  shift
+  "$lox" --script "$script" --immediate_result_dump "$@" 2>&1 |
+    grep -v -e '^Running lox file: ' -e '^Optimizer removed '
+  echo "exit ${PIPESTATUS[0]}"
+}
+
+failed=0
+for script in "$@"; do
+  expected="$expected_dir/$(basename "$script").out"
+  if [ $update = 1 ]; then
+    run "$script" --engine TREE > "$expected"
+    continue
+  fi
+  if [ ! -f "$expected" ]; then
+    echo "MISSING $expected"
+    failed=1
+    continue
+  fi
+  for engine in TREE VM CLOSURE; do
+    for optimize in "" "--optimize"; do
+      actual=$(run "$script" --engine "$engine" $optimize)
+      if [ "$actual" != "$(cat "$expected")" ]; then
+        echo "FAIL $script --engine $engine $optimize"
+        diff "$expected" <(echo "$actual") | head -20
+        failed=1
+      fi
+    done
+  done
+done
+
+[ $update = 0 ] && [ $failed = 0 ] && echo "Every engine matches the expected output of $# scripts."
+exit $failed
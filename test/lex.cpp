@@ -0,0 +1,105 @@
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "lox/lex.hpp"
+#include "lox/source.hpp"
+
+// Every lexer must produce exactly the tokens, symbols and errors of the sequential scanner, on each
+// script named on the command line and on all of them repeated. Fails if any differs.
+namespace
+{
+using Lexed = lox::result<std::vector<lox::Token>>;
+
+auto same_tokens(std::vector<lox::Token> const& lhs, std::vector<lox::Token> const& rhs) -> bool
+{
+  auto const same = [](lox::Token const& l, lox::Token const& r) {
+    return l.type == r.type && l.lexeme.data() == r.lexeme.data() && l.lexeme.size() == r.lexeme.size() &&
+           l.line == r.line && l.symbol == r.symbol && l.number == r.number;
+  };
+  return std::equal(lhs.begin(), lhs.end(), rhs.begin(), rhs.end(), same);
+}
+
+// Both lexed the same tokens and interned the same strings in the same order, or failed the same way
+auto same_lexing(Lexed const& expected,
+                 lox::StringPool const& expected_pool,
+                 Lexed const& actual,
+                 lox::StringPool const& actual_pool) -> bool
+{
+  if (expected.has_value() != actual.has_value()) return false;
+  if (!expected)
+  {
+    return expected.error().describe() == actual.error().describe() &&
+           expected.error().line == actual.error().line;
+  }
+  return same_tokens(*expected, *actual) && expected_pool.m_strings == actual_pool.m_strings;
+}
+
+auto backends_agree(std::string_view name, std::string_view source) -> bool
+{
+  lox::StringPool expected_pool;
+  lox::StringPool actual_pool;
+  auto const expected = lox::lex(source, &expected_pool, lox::LEX_BACKEND::SCANNER);
+  auto const actual = lox::lex(source, &actual_pool, lox::LEX_BACKEND::REGEX);
+  if (same_lexing(expected, expected_pool, actual, actual_pool)) return true;
+  fmt::print("FAIL {}: the REGEX backend differs from the SCANNER\n", name);
+  return false;
+}
+
+// Lexing source on any number of threads must match lexing it sequentially
+auto parallel_agrees(std::string_view name, std::string_view source) -> bool
+{
+  lox::StringPool expected_pool;
+  auto const expected = lox::lex(source, &expected_pool);
+  for (std::size_t threads = 2; threads <= 16; ++threads)
+  {
+    lox::StringPool actual_pool;
+    auto const actual = lox::lex_parallel(source, &actual_pool, threads);
+    if (same_lexing(expected, expected_pool, actual, actual_pool)) continue;
+    fmt::print("FAIL {}: lexing on {} threads differs from lexing sequentially\n", name, threads);
+    return false;
+  }
+  return true;
+}
+
+// Repeat the scripts until there is enough source to split between many threads. Chunk boundaries
+// then fall inside comments, strings and every other token in turn.
+auto repeated(std::vector<std::string> const& scripts) -> std::string
+{
+  constexpr std::size_t size = 2 << 20;
+  std::string source;
+  if (scripts.empty()) return source;
+  for (std::size_t i = 0; source.size() < size; ++i) source += scripts[i % scripts.size()] + "\n";
+  return source;
+}
+}  // namespace
+
+auto main(int argc, char* argv[]) -> int
+{
+  bool passed = true;
+  // Every script, and just those which lex without errors, so that the whole source is lexed
+  std::vector<std::string> scripts;
+  std::vector<std::string> lexable;
+  for (int i = 1; i < argc; ++i)
+  {
+    auto const source = lox::load_source(argv[i]);
+    if (!source)
+    {
+      fmt::print("FAIL {}: {}\n", argv[i], source.error().describe());
+      passed = false;
+      continue;
+    }
+    passed &= backends_agree(argv[i], source->view());
+    scripts.emplace_back(source->view());
+    lox::StringPool pool;
+    if (lox::lex(source->view(), &pool)) lexable.emplace_back(source->view());
+  }
+  passed &= parallel_agrees("every script repeated", repeated(scripts));
+  passed &= parallel_agrees("scripts without lexical errors repeated", repeated(lexable));
+  if (passed) fmt::print("Every lexer agrees on {} scripts.\n", argc - 1);
+  return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}